@@ -0,0 +1,200 @@
+////////////////////////////////////////////////////////////////////////////////
+//                                                                            //
+// Copyright (C) 2021-2023 Crypto Lab Inc.                                    //
+//                                                                            //
+// - This file is part of HEaaN homomorphic encryption library.               //
+// - HEaaN cannot be copied and/or distributed without the express permission //
+//  of Crypto Lab Inc.                                                        //
+//                                                                            //
+////////////////////////////////////////////////////////////////////////////////
+
+#pragma once
+
+#include <algorithm>
+#include <atomic>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+#include "Ciphertext.hpp"
+#include "Context.hpp"
+#include "HEaaNExport.hpp"
+#include "Integers.hpp"
+#include "Plaintext.hpp"
+
+namespace HEaaN {
+
+namespace detail {
+
+///@brief Touch every page of the polynomial buffers of ctxt
+HEAAN_API void prefault(const Context &context, Ciphertext &ctxt);
+///@brief Touch every page of the polynomial buffers of ptxt
+HEAAN_API void prefault(const Context &context, Plaintext &ptxt);
+
+} // namespace detail
+
+///
+///@brief A pool of Ciphertext or Plaintext objects of a Context whose
+/// polynomial buffers are reused instead of being freed
+///@details The library allocates the buffers of an object for the maximal
+/// level of its Context once, at construction, and most operations writing
+/// into an existing object reuse them whatever the level of the result: add,
+/// sub, mult, square, negate, rescale, levelDown and the *Inplace functions
+/// other than rotateInplace. A pooled object serves as their output without
+/// allocating output buffers, and the size class of the pool is its Context.
+/// leftRotate, rightRotate and conjugate are the exception: key switching
+/// produces their results in new buffers, which replace those of the output,
+/// so pooling their outputs saves nothing. Key switching also allocates
+/// scratch memory of its own in every case, mult included.
+///
+/// Idle objects are kept in one free list per hardware thread, selected by
+/// the calling thread, so concurrent workers rarely share a lock. A thread
+/// whose list is empty takes from the others before constructing a new
+/// object. An optional cap bounds the number of idle objects kept; objects
+/// released beyond it are destroyed.
+///
+/// Acquired objects hold unspecified data and should be used as outputs.
+///
+template <class T> class BufferPool {
+    struct State;
+
+public:
+    ///@brief Returns an object to its pool when the handle is destroyed
+    class Releaser {
+    public:
+        Releaser() = default;
+        explicit Releaser(std::shared_ptr<State> state)
+            : state_{std::move(state)} {}
+        void operator()(T *obj) const {
+            std::unique_ptr<T> owned(obj);
+            if (state_)
+                state_->release(std::move(owned));
+        }
+
+    private:
+        std::shared_ptr<State> state_;
+    };
+
+    ///@brief Handle owning an acquired object
+    using Handle = std::unique_ptr<T, Releaser>;
+
+    ///@param[in] context Context of the pooled objects
+    ///@param[in] max_idle Upper bound on the number of idle objects, or zero
+    /// for no bound
+    explicit BufferPool(const Context &context, u64 max_idle = 0)
+        : state_{std::make_shared<State>(context, max_idle)} {}
+
+    ///@brief Take an idle object, or construct one if there is none
+    ///@details The handle may outlive the pool.
+    Handle acquire() {
+        return Handle(state_->acquire().release(), Releaser(state_));
+    }
+
+    ///@brief Construct idle objects until there are count of them, and touch
+    /// their buffers so that later uses do not page-fault
+    ///@details count is clamped to getMaxIdle() when that is nonzero.
+    void reserve(u64 count) {
+        const u64 cap = state_->max_idle.load();
+        if (cap != 0 && count > cap)
+            count = cap;
+        while (state_->num_idle.load() < count) {
+            auto obj = std::make_unique<T>(state_->context);
+            detail::prefault(state_->context, *obj);
+            state_->release(std::move(obj), false);
+        }
+    }
+
+    ///@brief Get the number of idle objects
+    u64 getNumIdle() const { return state_->num_idle.load(); }
+
+    ///@brief Get the bound on the number of idle objects, zero meaning none
+    u64 getMaxIdle() const { return state_->max_idle.load(); }
+
+    ///@brief Set the bound on the number of idle objects, zero meaning none
+    ///@details Idle objects beyond the new bound are destroyed.
+    void setMaxIdle(u64 max_idle) {
+        state_->max_idle.store(max_idle);
+        state_->trim();
+    }
+
+    ///@brief Destroy all idle objects
+    void clear() {
+        for (auto &shard : state_->shards) {
+            std::lock_guard<std::mutex> lock(shard.mutex);
+            state_->num_idle -= shard.idle.size();
+            shard.idle.clear();
+        }
+    }
+
+private:
+    struct Shard {
+        std::mutex mutex;
+        std::vector<std::unique_ptr<T>> idle;
+    };
+
+    struct State {
+        State(const Context &context, u64 max_idle)
+            : context{context}, shards(std::max(
+                                    1U, std::thread::hardware_concurrency())),
+              num_idle{0}, max_idle{max_idle} {}
+
+        Shard &localShard() {
+            const auto id =
+                std::hash<std::thread::id>{}(std::this_thread::get_id());
+            return shards[id % shards.size()];
+        }
+
+        std::unique_ptr<T> acquire() {
+            Shard &local = localShard();
+            const u64 start = static_cast<u64>(&local - shards.data());
+            for (u64 i = 0; i < shards.size(); ++i) {
+                Shard &shard = shards[(start + i) % shards.size()];
+                std::lock_guard<std::mutex> lock(shard.mutex);
+                if (!shard.idle.empty()) {
+                    auto obj = std::move(shard.idle.back());
+                    shard.idle.pop_back();
+                    --num_idle;
+                    return obj;
+                }
+            }
+            return std::make_unique<T>(context);
+        }
+
+        void release(std::unique_ptr<T> obj, bool respect_cap = true) {
+            const u64 cap = max_idle.load();
+            if (respect_cap && cap != 0 && num_idle.load() >= cap)
+                return;
+            Shard &shard = localShard();
+            std::lock_guard<std::mutex> lock(shard.mutex);
+            shard.idle.push_back(std::move(obj));
+            ++num_idle;
+        }
+
+        void trim() {
+            const u64 cap = max_idle.load();
+            if (cap == 0)
+                return;
+            for (auto &shard : shards) {
+                std::lock_guard<std::mutex> lock(shard.mutex);
+                while (!shard.idle.empty() && num_idle.load() > cap) {
+                    shard.idle.pop_back();
+                    --num_idle;
+                }
+            }
+        }
+
+        const Context context;
+        std::vector<Shard> shards;
+        std::atomic<u64> num_idle;
+        std::atomic<u64> max_idle;
+    };
+
+    std::shared_ptr<State> state_;
+};
+
+using CiphertextPool = BufferPool<Ciphertext>;
+using PlaintextPool = BufferPool<Plaintext>;
+
+} // namespace HEaaN
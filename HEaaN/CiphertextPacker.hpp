@@ -0,0 +1,76 @@
+////////////////////////////////////////////////////////////////////////////////
+//                                                                            //
+// Copyright (C) 2021-2023 Crypto Lab Inc.                                    //
+//                                                                            //
+// - This file is part of HEaaN homomorphic encryption library.               //
+// - HEaaN cannot be copied and/or distributed without the express permission //
+//  of Crypto Lab Inc.                                                        //
+//                                                                            //
+////////////////////////////////////////////////////////////////////////////////
+
+#pragma once
+
+#include <istream>
+#include <ostream>
+#include <vector>
+
+#include "Ciphertext.hpp"
+#include "Context.hpp"
+#include "HEaaNExport.hpp"
+#include "Integers.hpp"
+
+namespace HEaaN {
+
+///
+///@brief Compact wire format for ciphertexts
+///@details Like Ciphertext::save, the packed format holds the residues of
+/// the levels up to getLevel() only, but each residue modulo q_i takes
+/// ceil(log2 q_i) bits instead of a full 64-bit word. HEaaN primes are well
+/// under 64 bits, so this saves about a third of the bytes for most
+/// parameters, on top of what dropping consumed levels saves.
+///
+/// The format is bound to the dimension and the primes of the context, which
+/// a Ciphertext does not expose by itself; hence the separate class.
+///
+class HEAAN_API CiphertextPacker {
+public:
+    explicit CiphertextPacker(const Context &context);
+
+    ///@brief Get the number of bytes save() writes for a ciphertext
+    ///@param[in] ctxt
+    u64 getPackedSize(const Ciphertext &ctxt) const;
+
+    ///@brief Save a ciphertext in the packed format
+    ///@param[in] ctxt
+    ///@param[out] stream
+    ///@throws RuntimeException if ctxt does not reside on CPU, is a mod-up
+    /// ciphertext or has more than three polynomials.
+    void save(const Ciphertext &ctxt, std::ostream &stream) const;
+
+    ///@brief Load a ciphertext saved by save()
+    ///@param[in] stream
+    ///@param[out] ctxt A ciphertext on CPU, resized to the saved size and
+    /// level
+    ///@details The whole ciphertext is read and validated before ctxt is
+    /// written, so a failed load leaves ctxt as it was.
+    ///@throws RuntimeException if ctxt does not reside on CPU.
+    ///@throws RuntimeException if the stream does not hold a packed
+    /// ciphertext of two or three polynomials fitting the dimension, levels,
+    /// number of slots and primes of the context, with a nonnegative rescale
+    /// counter.
+    void load(std::istream &stream, Ciphertext &ctxt) const;
+
+private:
+    ///@brief Words of packed residues at each level of a polynomial
+    u64 getNumWords(u64 level) const;
+
+    Context context_;
+    u64 degree_;
+    std::vector<u64> primes_;
+    ///@brief Maximal level of a ciphertext
+    u64 max_level_;
+    ///@brief Bits per residue at each level
+    std::vector<u64> bits_;
+};
+
+} // namespace HEaaN
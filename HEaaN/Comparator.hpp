@@ -0,0 +1,127 @@
+////////////////////////////////////////////////////////////////////////////////
+//                                                                            //
+// Copyright (C) 2021-2023 Crypto Lab Inc.                                    //
+//                                                                            //
+// - This file is part of HEaaN homomorphic encryption library.               //
+// - HEaaN cannot be copied and/or distributed without the express permission //
+//  of Crypto Lab Inc.                                                        //
+//                                                                            //
+////////////////////////////////////////////////////////////////////////////////
+
+#pragma once
+
+#include <vector>
+
+#include "Bootstrapper.hpp"
+#include "HEaaNExport.hpp"
+#include "HomEvaluator.hpp"
+#include "Integers.hpp"
+#include "PolynomialEvaluator.hpp"
+#include "Real.hpp"
+
+namespace HEaaN {
+
+class Ciphertext;
+
+///@brief Precision of the comparison functions, which determines their
+/// latency
+struct ComparisonConfig {
+    ///@brief Inputs x with |x| >= 2^-log_gap are resolved. Smaller inputs
+    /// (or differences of compared values) yield unspecified results in
+    /// [-1, 1].
+    u64 log_gap = 8;
+    ///@brief The sign of a resolved input is computed up to an error of
+    /// 2^-log_error, on top of the approximation error of the scheme.
+    u64 log_error = 12;
+};
+
+///
+///@brief A class computing sign, comparison, max, min and ReLU on encrypted
+/// real numbers in [-1, 1]
+///@details sign(x) is approximated by a composition of odd polynomials of
+/// degree 7 (Cheon, Kim, Kim, Lee and Lee, Asiacrypt 2020): g amplifies small
+/// inputs by a factor of about 4.48 per iteration and f, whose derivative is a
+/// multiple of (1 - x^2)^3, pulls the result to ±1. The numbers of g and f
+/// iterations are the smallest ones meeting the ComparisonConfig and are
+/// fixed at construction. Every iteration consumes three levels, and relu, max
+/// and min one more after the last iteration. A bootstrap is inserted before
+/// an iteration whenever the level would otherwise drop below
+/// Bootstrapper::getMinLevelForBootstrap(), and relu, max and min bootstrap
+/// their input at that level before multiplying by it, so the outputs of
+/// inputs which can be bootstrapped can always be bootstrapped again, e.g.
+/// max(max(a, b), c).
+///
+class HEAAN_API Comparator {
+public:
+    ///@param[in] eval
+    ///@param[in] btp Bootstrapper whose constants are ready for the number of
+    /// slots of the inputs
+    ///@param[in] config
+    ///@throws RuntimeException if log_gap or log_error is zero or larger than
+    /// 30.
+    ///@throws RuntimeException if the level after bootstrap is too low for an
+    /// iteration followed by the multiplication of relu.
+    explicit Comparator(const HomEvaluator &eval, const Bootstrapper &btp,
+                        const ComparisonConfig &config = ComparisonConfig());
+
+    ///@brief Get the number of iterations of g
+    u64 getNumGIterations() const { return num_g_iters_; }
+
+    ///@brief Get the number of iterations of f
+    u64 getNumFIterations() const { return num_f_iters_; }
+
+    ///@brief Get the number of levels sign() consumes, bootstraps aside
+    u64 getDepth() const;
+
+    ///@brief Compute sign(x) for each slot of ctxt
+    ///@param[in] ctxt Ciphertext encrypting real numbers in [-1, 1]
+    ///@param[out] ctxt_out
+    ///@throws RuntimeException if ctxt has nonzero rescale counter.
+    ///@throws RuntimeException if a bootstrap is needed but the level of ctxt
+    /// is less than Bootstrapper::getMinLevelForBootstrap().
+    void sign(const Ciphertext &ctxt, Ciphertext &ctxt_out) const;
+
+    ///@brief Compute 1 if a > b, 0 if a < b for each slot
+    ///@param[in] ctxt1 a
+    ///@param[in] ctxt2 b
+    ///@param[out] ctxt_out
+    ///@details a - b should lie in [-1, 1]. Slots where |a - b| is below the
+    /// gap yield values in [0, 1].
+    ///@throws RuntimeException as in sign().
+    void compare(const Ciphertext &ctxt1, const Ciphertext &ctxt2,
+                 Ciphertext &ctxt_out) const;
+
+    ///@brief Compute max(a, b) for each slot
+    ///@details Computed as b + relu(a - b); a - b should lie in [-1, 1].
+    ///@throws RuntimeException as in sign().
+    void max(const Ciphertext &ctxt1, const Ciphertext &ctxt2,
+             Ciphertext &ctxt_out) const;
+
+    ///@brief Compute min(a, b) for each slot
+    ///@details Computed as a - relu(a - b); a - b should lie in [-1, 1].
+    ///@throws RuntimeException as in sign().
+    void min(const Ciphertext &ctxt1, const Ciphertext &ctxt2,
+             Ciphertext &ctxt_out) const;
+
+    ///@brief Compute max(x, 0) for each slot
+    ///@details Computed as x * (1 + sign(x)) / 2, where the halving is folded
+    /// into the last polynomial.
+    ///@throws RuntimeException as in sign().
+    void relu(const Ciphertext &ctxt, Ciphertext &ctxt_out) const;
+
+private:
+    ///@brief scale * sign(x) + shift, where the affine map is folded into the
+    /// coefficients of the last polynomial
+    ///@details The result keeps extra_depth levels above
+    /// Bootstrapper::getMinLevelForBootstrap() for the caller to spend.
+    void signAffine(const Ciphertext &ctxt, Real scale, Real shift,
+                    u64 extra_depth, Ciphertext &ctxt_out) const;
+
+    const HomEvaluator eval_;
+    const Bootstrapper btp_;
+    PolynomialEvaluator poly_eval_;
+    u64 num_g_iters_;
+    u64 num_f_iters_;
+};
+
+} // namespace HEaaN
@@ -0,0 +1,118 @@
+////////////////////////////////////////////////////////////////////////////////
+//                                                                            //
+// Copyright (C) 2021-2023 Crypto Lab Inc.                                    //
+//                                                                            //
+// - This file is part of HEaaN homomorphic encryption library.               //
+// - HEaaN cannot be copied and/or distributed without the express permission //
+//  of Crypto Lab Inc.                                                        //
+//                                                                            //
+////////////////////////////////////////////////////////////////////////////////
+
+#pragma once
+
+#include <list>
+#include <memory>
+#include <mutex>
+#include <tuple>
+#include <unordered_map>
+
+#include "Context.hpp"
+#include "EnDecoder.hpp"
+#include "HEaaNExport.hpp"
+#include "Integers.hpp"
+#include "Message.hpp"
+#include "Plaintext.hpp"
+
+namespace HEaaN {
+
+///
+///@brief A bounded cache of the Plaintext encodings of Message
+///@details Encoding a message runs an FFT, a CRT decomposition and an NTT on
+/// every call. The cache keeps the plaintexts it encodes, keyed by a hash of
+/// the slot values together with the level and the rescale counter, so that a
+/// message encoded again at the same level is served without that work. A hit
+/// is confirmed by comparing the slot values, so hash collisions never return
+/// a wrong plaintext.
+///
+/// When a memory budget is set, the least recently used plaintexts are dropped
+/// once the cached plaintexts and messages exceed it. Plaintexts are handed
+/// out as shared pointers, so a dropped plaintext stays valid for as long as
+/// the caller holds it.
+///
+/// The HomEvaluator overloads of add, sub and mult taking a Message and an
+/// EncodeCache encode through it. An EncodeCache may be shared by several
+/// threads.
+///
+class HEAAN_API EncodeCache {
+public:
+    ///@param[in] context Context of the encoded plaintexts
+    ///@param[in] memory_budget Upper bound in bytes on the cached plaintexts
+    /// and messages, or zero for no bound
+    explicit EncodeCache(const Context &context, u64 memory_budget = 0);
+
+    ///@brief Get the encoding of msg at a level and a rescale counter
+    ///@param[in] msg Input message
+    ///@param[in] level Target level
+    ///@param[in] r_counter Target rescale counter
+    ///@returns The cached plaintext if msg was encoded at level and r_counter
+    /// before, and a new encoding otherwise.
+    ///@throws RuntimeException if msg does not reside on CPU.
+    ///@throws RuntimeException if EnDecoder::encode(msg, level, r_counter)
+    /// throws.
+    std::shared_ptr<const Plaintext> encode(const Message &msg, u64 level,
+                                            int r_counter = 0);
+
+    ///@brief Get the memory budget in bytes, zero meaning no bound
+    u64 getMemoryBudget() const;
+
+    ///@brief Set the memory budget in bytes, zero meaning no bound
+    ///@details Cached plaintexts are dropped right away to fit a smaller
+    /// budget.
+    void setMemoryBudget(u64 memory_budget);
+
+    ///@brief Get the bytes held by the cached plaintexts and messages
+    ///@details A plaintext is accounted for by the residues it holds at its
+    /// level, i.e. (level + 1) * N words.
+    u64 getMemoryUsage() const;
+
+    ///@brief Get the number of cached plaintexts
+    u64 getNumCachedPlaintexts() const;
+
+    ///@brief Get the number of calls to encode() served from the cache
+    u64 getNumHits() const;
+
+    ///@brief Get the number of calls to encode() which encoded the message
+    u64 getNumMisses() const;
+
+    ///@brief Drop all cached plaintexts and reset the counters
+    void clear();
+
+private:
+    // (hash of the slot values, log_slots, level, r_counter)
+    using Key = std::tuple<u64, u64, u64, int>;
+    struct KeyHash {
+        std::size_t operator()(const Key &key) const;
+    };
+    struct Entry {
+        Message msg;
+        std::shared_ptr<const Plaintext> ptxt;
+        u64 bytes;
+        std::list<Key>::iterator lru_pos;
+    };
+
+    void evictToBudget();
+
+    const Context context_;
+    const EnDecoder encoder_;
+    mutable std::mutex mutex_;
+    u64 memory_budget_;
+    u64 memory_usage_;
+    u64 num_hits_;
+    u64 num_misses_;
+    ///@brief Cached plaintexts keyed by (hash, log_slots, level, r_counter)
+    std::unordered_map<Key, Entry, KeyHash> cache_;
+    ///@brief Keys of cache_ from the most to the least recently used
+    std::list<Key> lru_;
+};
+
+} // namespace HEaaN
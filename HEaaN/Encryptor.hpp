@@ -10,8 +10,11 @@
 
 #pragma once
 
+#include <functional>
+
 #include "Context.hpp"
 #include "HEaaNExport.hpp"
+#include "Span.hpp"
 
 namespace HEaaN {
 
@@ -81,6 +84,64 @@ public:
     void encrypt(const Plaintext &ptxt, const KeyPack &keypack,
                  Ciphertext &ctxt) const;
 
+    ///@brief Receives the index of a message of a batch and its ciphertext
+    using BatchSink = std::function<void(u64, Ciphertext &)>;
+
+    ///@brief Encrypt many messages using a keypack (Public key encryption)
+    ///@param[in] msgs
+    ///@param[in] keypack
+    ///@param[out] ctxts ctxts[i] is the encryption of msgs[i]
+    ///@param[in] level
+    ///@param[in] r_counter
+    ///@param[in] sink Optional function called with (i, ctxts[i]) as soon as
+    /// ctxts[i] is ready
+    ///@details The messages are encoded, sampled and encrypted on OpenMP
+    /// worker threads, one message per thread at a time, so that every stage
+    /// of one message overlaps with the others. Calls to sink are serialized
+    /// and come in order of completion. Each thread draws from its own random
+    /// generator, so setSeed() on the calling thread does not make a batch
+    /// reproducible.
+    ///@throws RuntimeException if msgs and ctxts have the different size.
+    ///@throws RuntimeException if any msg and key are at different devices.
+    void encryptBatch(Span<const Message> msgs, const KeyPack &keypack,
+                      Span<Ciphertext> ctxts, u64 level, int r_counter = 0,
+                      const BatchSink &sink = nullptr) const;
+
+    ///@brief Encrypt many messages using a secret key
+    ///@details Same as the keypack overload of encryptBatch with outputs.
+    ///@throws RuntimeException if msgs and ctxts have the different size.
+    ///@throws RuntimeException if any msg and key are at different devices.
+    void encryptBatch(Span<const Message> msgs, const SecretKey &sk,
+                      Span<Ciphertext> ctxts, u64 level, int r_counter = 0,
+                      const BatchSink &sink = nullptr) const;
+
+    ///@brief Encrypt many messages using a keypack into a sink
+    ///@param[in] msgs
+    ///@param[in] keypack
+    ///@param[in] sink Function called with (i, the encryption of msgs[i]) for
+    /// every i
+    ///@param[in] level
+    ///@param[in] r_counter
+    ///@details The ciphertext passed to sink is only valid during the call,
+    /// which may move it out or save it. A ciphertext which is not moved out
+    /// is freed right after the call, so a sink which only writes the
+    /// ciphertexts out keeps the memory of a batch bounded by the number of
+    /// threads rather than the number of messages. Threads and randomness
+    /// are as in the overloads with outputs.
+    ///@throws RuntimeException if sink is empty.
+    ///@throws RuntimeException if any msg and key are at different devices.
+    void encryptBatch(Span<const Message> msgs, const KeyPack &keypack,
+                      const BatchSink &sink, u64 level,
+                      int r_counter = 0) const;
+
+    ///@brief Encrypt many messages using a secret key into a sink
+    ///@details Same as the keypack overload of encryptBatch into a sink.
+    ///@throws RuntimeException if sink is empty.
+    ///@throws RuntimeException if any msg and key are at different devices.
+    void encryptBatch(Span<const Message> msgs, const SecretKey &sk,
+                      const BatchSink &sink, u64 level,
+                      int r_counter = 0) const;
+
 private:
     ///@brief A context with which Encryptor is associated
     const Context context_;
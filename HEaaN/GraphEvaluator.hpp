@@ -0,0 +1,138 @@
+////////////////////////////////////////////////////////////////////////////////
+//                                                                            //
+// Copyright (C) 2021-2023 Crypto Lab Inc.                                    //
+//                                                                            //
+// - This file is part of HEaaN homomorphic encryption library.               //
+// - HEaaN cannot be copied and/or distributed without the express permission //
+//  of Crypto Lab Inc.                                                        //
+//                                                                            //
+////////////////////////////////////////////////////////////////////////////////
+
+#pragma once
+
+#include <map>
+#include <tuple>
+#include <vector>
+
+#include "HEaaNExport.hpp"
+#include "HomEvaluator.hpp"
+#include "Integers.hpp"
+#include "Real.hpp"
+
+namespace HEaaN {
+
+class Ciphertext;
+class Plaintext;
+
+///
+///@brief A deferred counterpart of HomEvaluator which records operations into
+/// a graph and executes the graph as a whole
+///@details Each call returns the node of its result instead of computing it.
+/// While recording, identical operations on the same nodes are merged, and
+/// levelDown calls which do not lower the level or follow another levelDown
+/// are folded. execute() then
+///  - runs only the nodes the requested outputs depend on;
+///  - fuses sums of products into HomEvaluator::innerProduct-like kernels, so
+///    that a sum of n products is rescaled (and relinearized) once instead of
+///    n times;
+///  - computes all the rotations of a node together with the multi-rotation
+///    leftRotate;
+///  - runs independent nodes in parallel, in waves of the dependency graph;
+///  - recycles the ciphertexts of intermediate results as soon as their last
+///    consumer has run.
+///
+/// Input ciphertexts and plaintexts are referenced, not copied, and should
+/// outlive the executions. The graph may be executed several times, e.g.
+/// after the inputs were overwritten with new data at the same levels.
+///
+class HEAAN_API GraphEvaluator {
+public:
+    using NodeId = u64;
+
+    explicit GraphEvaluator(const HomEvaluator &eval);
+
+    ///@brief Record an input ciphertext
+    ///@throws RuntimeException if ctxt has nonzero rescale counter.
+    NodeId input(const Ciphertext &ctxt);
+
+    ///@brief Record HomEvaluator::add of two nodes
+    NodeId add(NodeId op1, NodeId op2);
+    ///@brief Record HomEvaluator::add of a node and a constant
+    NodeId add(NodeId op, const Complex &cnst_complex);
+    ///@brief Record HomEvaluator::sub of two nodes
+    NodeId sub(NodeId op1, NodeId op2);
+    ///@brief Record HomEvaluator::negate
+    NodeId negate(NodeId op);
+    ///@brief Record HomEvaluator::mult of two nodes
+    NodeId mult(NodeId op1, NodeId op2);
+    ///@brief Record HomEvaluator::mult of a node and a plaintext
+    NodeId mult(NodeId op, const Plaintext &ptxt);
+    ///@brief Record HomEvaluator::mult of a node and a constant
+    NodeId mult(NodeId op, const Complex &cnst_complex);
+    ///@brief Record HomEvaluator::square
+    NodeId square(NodeId op);
+    ///@brief Record HomEvaluator::leftRotate
+    NodeId leftRotate(NodeId op, u64 rot);
+    ///@brief Record HomEvaluator::levelDown
+    ///@throws RuntimeException if target_level is above the level of op.
+    NodeId levelDown(NodeId op, u64 target_level);
+
+    ///@brief Get the level the node will have after execution
+    u64 getLevel(NodeId node) const;
+
+    ///@brief Get the number of recorded nodes, after merging
+    u64 getNumNodes() const { return nodes_.size(); }
+
+    ///@brief Compute the given nodes
+    ///@param[in] outputs
+    ///@param[out] ctxts_out Resized to outputs.size(); ctxts_out[i] receives
+    /// the value of outputs[i]
+    ///@throws RuntimeException if an input changed its level or rescale
+    /// counter since it was recorded.
+    void execute(const std::vector<NodeId> &outputs,
+                 std::vector<Ciphertext> &ctxts_out) const;
+
+    ///@brief Remove all the recorded nodes
+    void clear();
+
+private:
+    enum class OpType {
+        INPUT,
+        ADD,
+        ADD_CONST,
+        SUB,
+        NEGATE,
+        MULT,
+        MULT_PTXT,
+        MULT_CONST,
+        SQUARE,
+        LEFT_ROTATE,
+        LEVEL_DOWN,
+    };
+
+    struct Node {
+        OpType op;
+        NodeId lhs;
+        NodeId rhs;
+        u64 param;
+        Complex cnst;
+        const Ciphertext *ctxt;
+        const Plaintext *ptxt;
+        u64 level;
+    };
+
+    using Key = std::tuple<OpType, NodeId, NodeId, u64, Real, Real,
+                           const void *>;
+
+    NodeId record(const char *func, Node node);
+    void checkNode(const char *func, NodeId node) const;
+
+    ///@brief Evaluator running the operations
+    const HomEvaluator eval_;
+    ///@brief Nodes in topological order: operands precede their users
+    std::vector<Node> nodes_;
+    ///@brief Recorded operations, for merging identical ones
+    std::map<Key, NodeId> index_;
+};
+
+} // namespace HEaaN
@@ -11,23 +11,40 @@
 #pragma once
 
 #include "Bootstrapper.hpp"
+#include "BufferPool.hpp"
 #include "Ciphertext.hpp"
+#include "CiphertextPacker.hpp"
+#include "Comparator.hpp"
 #include "Context.hpp"
 #include "Decryptor.hpp"
 #include "EnDecoder.hpp"
+#include "EncodeCache.hpp"
 #include "Encryptor.hpp"
+#include "GraphEvaluator.hpp"
 #include "HEaaNExport.hpp"
 #include "HomEvaluator.hpp"
 #include "Integers.hpp"
 #include "KeyGenerator.hpp"
 #include "KeyPack.hpp"
+#include "KeyStore.hpp"
+#include "LinearTransform.hpp"
+#include "MathEvaluator.hpp"
 #include "Message.hpp"
 #include "ParameterPreset.hpp"
 #include "Plaintext.hpp"
+#include "PolynomialEvaluator.hpp"
+#include "PowerBasis.hpp"
+#include "PreparedPlaintext.hpp"
 #include "Pointer.hpp"
 #include "Randomseeds.hpp"
 #include "Real.hpp"
+#include "ResidueLayout.hpp"
+#include "RotationKeyCache.hpp"
 #include "SecretKey.hpp"
+#include "SeededCiphertext.hpp"
+#include "SeededEvaluationKey.hpp"
+#include "SharedCiphertext.hpp"
+#include "Span.hpp"
 
 #include "multiparty/CollectiveKeyGenConfig.hpp"
 #include "multiparty/CollectiveKeyGenData.hpp"
@@ -15,16 +15,29 @@
 #include "HEaaNExport.hpp"
 #include "KeyPack.hpp"
 #include "Real.hpp"
+#include "Span.hpp"
 
 namespace HEaaN {
 
 class Message;
 class Plaintext;
 class Ciphertext;
+class EncodeCache;
+class PreparedPlaintext;
 class HomEvaluatorImpl;
 
 ///
 ///@brief A class consisting of basic operation of Ciphertext and Message
+///@details Every operation accepts one of its inputs as its output, e.g.
+/// add(a, b, a) or mult(a, b, a). Except for leftRotate, rightRotate and
+/// conjugate, an operation on CPU writes its result into the existing buffers
+/// of ctxt_out, so using an input or a previously used Ciphertext as the
+/// output does not allocate output buffers. Key switching, i.e. in mult,
+/// square and relinearize of ciphertexts as well as in rotations and
+/// conjugation, still allocates scratch; see reserveWorkspace(). Key
+/// switching in leftRotate, rightRotate and conjugate also produces the
+/// result in new buffers, which replace those of ctxt_out. The *Inplace
+/// functions spell out these guarantees for the common in-place updates.
 ///
 class HEAAN_API HomEvaluator {
     friend class BootstrapperImpl;
@@ -95,6 +108,15 @@ public:
     /// is a Ciphertext which encrypts the sum of those two messages.
     void add(const Ciphertext &ctxt1, const Message &msg2,
              Ciphertext &ctxt_out) const;
+    ///@brief Ciphertext + Message, with msg2 encoded through a cache
+    ///@param[in] ctxt1
+    ///@param[in] msg2
+    ///@param[in] cache
+    ///@param[out] ctxt_out
+    ///@details Same as add(ctxt1, msg2, ctxt_out), except that the encoding
+    /// of msg2 at the level and rescale counter of ctxt1 is taken from cache.
+    void add(const Ciphertext &ctxt1, const Message &msg2, EncodeCache &cache,
+             Ciphertext &ctxt_out) const;
     ///@brief Ciphertext + Plaintext
     ///@param[in] ctxt1
     ///@param[in] ptxt2
@@ -104,6 +126,14 @@ public:
     /// level.
     void add(const Ciphertext &ctxt1, const Plaintext &ptxt2,
              Ciphertext &ctxt_out) const;
+    ///@brief Ciphertext + PreparedPlaintext
+    ///@param[in] ctxt1
+    ///@param[in] ptxt2
+    ///@param[out] ctxt_out
+    ///@details Same as add(ctxt1, ptxt2.getPlaintext(ctxt1.getLevel()),
+    /// ctxt_out).
+    void add(const Ciphertext &ctxt1, const PreparedPlaintext &ptxt2,
+             Ciphertext &ctxt_out) const;
     ///@brief Ciphertext + Ciphertext
     ///@param[in] ctxt1
     ///@param[in] ctxt2
@@ -115,6 +145,37 @@ public:
     /// rescale counter
     void add(const Ciphertext &ctxt1, const Ciphertext &ctxt2,
              Ciphertext &ctxt_out) const;
+    ///@brief Ciphertext + Ciphertext for many pairs of Ciphertext
+    ///@param[in] ctxts1
+    ///@param[in] ctxts2
+    ///@param[out] ctxts_out
+    ///@details ctxts_out[i] = ctxts1[i] + ctxts2[i]. With at least as many
+    /// ciphertexts as OpenMP threads, the work is split across threads by
+    /// ciphertext rather than inside each polynomial; with fewer, the
+    /// ciphertexts are processed one after another, each with all the threads.
+    ///@throws RuntimeException if ctxts1, ctxts2 and ctxts_out have the
+    /// different size
+    void add(Span<const Ciphertext> ctxts1, Span<const Ciphertext> ctxts2,
+             Span<Ciphertext> ctxts_out) const;
+    ///@brief ctxt += ctxt2
+    ///@param[in, out] ctxt
+    ///@param[in] ctxt2
+    ///@details Same as add(ctxt, ctxt2, ctxt). The sum is written into the
+    /// buffers of ctxt without allocation.
+    ///@throws RuntimeException if ctxt and ctxt2 have the different rescale
+    /// counter
+    void addInplace(Ciphertext &ctxt, const Ciphertext &ctxt2) const;
+    ///@brief ctxt += ptxt
+    ///@param[in, out] ctxt
+    ///@param[in] ptxt
+    ///@details Same as add(ctxt, ptxt, ctxt), without allocation.
+    void addInplace(Ciphertext &ctxt, const Plaintext &ptxt) const;
+    ///@brief ctxt += cnst_complex
+    ///@param[in, out] ctxt
+    ///@param[in] cnst_complex
+    ///@details Same as add(ctxt, cnst_complex, ctxt), without allocation.
+    ///@throws RuntimeException if ctxt has nonzero rescale counter.
+    void addInplace(Ciphertext &ctxt, const Complex &cnst_complex) const;
 
     ///@brief Message - Complex Constant
     ///@param[in] msg1
@@ -165,6 +226,15 @@ public:
     /// those two messages.
     void sub(const Ciphertext &ctxt1, const Message &msg2,
              Ciphertext &ctxt_out) const;
+    ///@brief Ciphertext - Message, with msg2 encoded through a cache
+    ///@param[in] ctxt1
+    ///@param[in] msg2
+    ///@param[in] cache
+    ///@param[out] ctxt_out
+    ///@details Same as sub(ctxt1, msg2, ctxt_out), except that the encoding
+    /// of msg2 at the level and rescale counter of ctxt1 is taken from cache.
+    void sub(const Ciphertext &ctxt1, const Message &msg2, EncodeCache &cache,
+             Ciphertext &ctxt_out) const;
     ///@brief Ciphertext - Plaintext
     ///@param[in] ctxt1
     ///@param[in] ptxt2
@@ -174,6 +244,14 @@ public:
     /// level.
     void sub(const Ciphertext &ctxt1, const Plaintext &ptxt2,
              Ciphertext &ctxt_out) const;
+    ///@brief Ciphertext - PreparedPlaintext
+    ///@param[in] ctxt1
+    ///@param[in] ptxt2
+    ///@param[out] ctxt_out
+    ///@details Same as sub(ctxt1, ptxt2.getPlaintext(ctxt1.getLevel()),
+    /// ctxt_out).
+    void sub(const Ciphertext &ctxt1, const PreparedPlaintext &ptxt2,
+             Ciphertext &ctxt_out) const;
     ///@brief Ciphertext - Ciphertext
     ///@param[in] ctxt1
     ///@param[in] ctxt2
@@ -185,6 +263,18 @@ public:
     /// rescale counter
     void sub(const Ciphertext &ctxt1, const Ciphertext &ctxt2,
              Ciphertext &ctxt_out) const;
+    ///@brief Ciphertext - Ciphertext for many pairs of Ciphertext
+    ///@param[in] ctxts1
+    ///@param[in] ctxts2
+    ///@param[out] ctxts_out
+    ///@details ctxts_out[i] = ctxts1[i] - ctxts2[i]. With at least as many
+    /// ciphertexts as OpenMP threads, the work is split across threads by
+    /// ciphertext rather than inside each polynomial; with fewer, the
+    /// ciphertexts are processed one after another, each with all the threads.
+    ///@throws RuntimeException if ctxts1, ctxts2 and ctxts_out have the
+    /// different size
+    void sub(Span<const Ciphertext> ctxts1, Span<const Ciphertext> ctxts2,
+             Span<Ciphertext> ctxts_out) const;
 
     ///@brief Message * Complex Constant
     ///@param[in] msg1
@@ -243,6 +333,16 @@ public:
     ///@throws RuntimeException if ctxt1 has nonzero rescale counter.
     void mult(const Ciphertext &ctxt1, const Message &msg2,
               Ciphertext &ctxt_out) const;
+    ///@brief Ciphertext * Message, with msg2 encoded through a cache
+    ///@param[in] ctxt1
+    ///@param[in] msg2
+    ///@param[in] cache
+    ///@param[out] ctxt_out
+    ///@details Same as mult(ctxt1, msg2, ctxt_out), except that the encoding
+    /// of msg2 at the level of ctxt1 is taken from cache.
+    ///@throws RuntimeException if ctxt1 has nonzero rescale counter.
+    void mult(const Ciphertext &ctxt1, const Message &msg2, EncodeCache &cache,
+              Ciphertext &ctxt_out) const;
     ///@brief Ciphertext * Plaintext
     ///@param[in] ctxt1
     ///@param[in] ptxt2
@@ -254,6 +354,14 @@ public:
     /// counter.
     void mult(const Ciphertext &ctxt1, const Plaintext &ptxt2,
               Ciphertext &ctxt_out) const;
+    ///@brief Ciphertext * PreparedPlaintext
+    ///@param[in] ctxt1
+    ///@param[in] ptxt2
+    ///@param[out] ctxt_out
+    ///@details Same as mult(ctxt1, ptxt2.getPlaintext(ctxt1.getLevel()),
+    /// ctxt_out), so the plaintext is never releveled per call.
+    void mult(const Ciphertext &ctxt1, const PreparedPlaintext &ptxt2,
+              Ciphertext &ctxt_out) const;
     ///@brief Ciphertext * Ciphertext
     ///@param[in] ctxt1
     ///@param[in] ctxt2
@@ -265,6 +373,41 @@ public:
     /// counter.
     void mult(const Ciphertext &ctxt1, const Ciphertext &ctxt2,
               Ciphertext &ctxt_out) const;
+    ///@brief Ciphertext * Ciphertext for many pairs of Ciphertext
+    ///@param[in] ctxts1
+    ///@param[in] ctxts2
+    ///@param[out] ctxts_out
+    ///@details ctxts_out[i] = ctxts1[i] * ctxts2[i]. With at least as many
+    /// ciphertexts as OpenMP threads, the work is split across threads by
+    /// ciphertext rather than inside each polynomial; with fewer, the
+    /// ciphertexts are processed one after another, each with all the threads.
+    ///@throws RuntimeException if ctxts1, ctxts2 and ctxts_out have the
+    /// different size
+    void mult(Span<const Ciphertext> ctxts1, Span<const Ciphertext> ctxts2,
+              Span<Ciphertext> ctxts_out) const;
+    ///@brief ctxt *= ctxt2
+    ///@param[in, out] ctxt
+    ///@param[in] ctxt2
+    ///@details Same as mult(ctxt, ctxt2, ctxt). The relinearized and rescaled
+    /// product is written into the buffers of ctxt without allocating an
+    /// output.
+    ///@throws RuntimeException if any of the input operands has nonzero rescale
+    /// counter.
+    void multInplace(Ciphertext &ctxt, const Ciphertext &ctxt2) const;
+    ///@brief ctxt *= ptxt
+    ///@param[in, out] ctxt
+    ///@param[in] ptxt
+    ///@details Same as mult(ctxt, ptxt, ctxt), without allocating an output.
+    ///@throws RuntimeException if any of the input operands has nonzero rescale
+    /// counter.
+    void multInplace(Ciphertext &ctxt, const Plaintext &ptxt) const;
+    ///@brief ctxt *= cnst_complex
+    ///@param[in, out] ctxt
+    ///@param[in] cnst_complex
+    ///@details Same as mult(ctxt, cnst_complex, ctxt), without allocating an
+    /// output.
+    ///@throws RuntimeException if ctxt has nonzero rescale counter.
+    void multInplace(Ciphertext &ctxt, const Complex &cnst_complex) const;
 
     ///@brief multiply a Message by the imaginary unit √(-1)
     ///@param[in] msg
@@ -308,6 +451,16 @@ public:
     ///@param[out] ctxt_out
     void square(const Ciphertext &ctxt, Ciphertext &ctxt_out) const;
 
+    ///@brief Compute the square of many Ciphertext
+    ///@param[in] ctxts
+    ///@param[out] ctxts_out
+    ///@details With at least as many ciphertexts as OpenMP threads, the work is
+    /// split across threads by ciphertext rather than inside each polynomial;
+    /// with fewer, the ciphertexts are processed one after another, each with
+    /// all the threads.
+    ///@throws RuntimeException if ctxts and ctxts_out have the different size
+    void square(Span<const Ciphertext> ctxts, Span<Ciphertext> ctxts_out) const;
+
     ///@brief Rotate components of Message by rot
     ///@param[in] msg
     ///@param[in] rot
@@ -329,6 +482,41 @@ public:
     void leftRotate(const Ciphertext &ctxt, u64 rot,
                     Ciphertext &ctxt_out) const;
 
+    ///@brief Rotate the message which Ciphertext encrypts by several amounts
+    ///@param[in] ctxt
+    ///@param[in] rots Rotation amounts
+    ///@param[out] ctxts_out
+    ///@details ctxts_out[i] = leftRotate(ctxt, rots[i]). Rotation amounts are
+    /// reduced modulo the number of slots, amounts which coincide are evaluated
+    /// only once, and the distinct rotations run concurrently when there are at
+    /// least as many of them as OpenMP threads, and one after another
+    /// otherwise. Each distinct rotation is a full key switching of its own;
+    /// the decomposition of ctxt is not shared between them. ctxts_out is
+    /// resized to rots.size(); elements which already exist are reused as
+    /// output buffers, and ctxt may be one of them.
+    void leftRotate(const Ciphertext &ctxt, const std::vector<u64> &rots,
+                    std::vector<Ciphertext> &ctxts_out) const;
+    ///@brief Rotate the message which ctxt encrypts to the left by rot, in
+    /// place
+    ///@param[in, out] ctxt
+    ///@param[in] rot
+    ///@details Same as leftRotate(ctxt, rot, ctxt). Key switching produces
+    /// the result in new buffers, which are moved into ctxt; no copy of the
+    /// rotated ciphertext is made.
+    void rotateInplace(Ciphertext &ctxt, u64 rot) const;
+
+    ///@brief Rotate the messages which many Ciphertext encrypt by rot
+    ///@param[in] ctxts
+    ///@param[in] rot
+    ///@param[out] ctxts_out
+    ///@details ctxts_out[i] = leftRotate(ctxts[i], rot). With at least as many
+    /// ciphertexts as OpenMP threads, the work is split across threads by
+    /// ciphertext rather than inside each polynomial; with fewer, the
+    /// ciphertexts are processed one after another, each with all the threads.
+    ///@throws RuntimeException if ctxts and ctxts_out have the different size
+    void leftRotate(Span<const Ciphertext> ctxts, u64 rot,
+                    Span<Ciphertext> ctxts_out) const;
+
     ///@brief Rotate components of Message by rot
     ///@param[in] msg
     ///@param[in] rot
@@ -356,6 +544,30 @@ public:
     ///@details We suppose that all Ciphertext have the same level
     void rotSum(const std::vector<Ciphertext> &ctxt,
                 const std::vector<u64> &rot_idx, Ciphertext &ctxt_out) const;
+    ///@brief Compute Σ leftRotate(ctxts[i], rots[i])
+    ///@param[in] ctxts
+    ///@param[in] rots
+    ///@param[out] ctxt_out
+    ///@details The inputs are viewed in place rather than copied. Rotation is
+    /// linear, so the inputs whose amounts coincide modulo the number of slots
+    /// are summed first and rotated once, and the distinct rotations run
+    /// concurrently when there are at least as many of them as OpenMP threads,
+    /// and one after another otherwise. Inputs at different levels are adjusted
+    /// as in add.
+    ///@throws RuntimeException if ctxts and rots have the different size or
+    /// are empty.
+    void rotSum(Span<const Ciphertext> ctxts, const std::vector<u64> &rots,
+                Ciphertext &ctxt_out) const;
+    ///@brief Compute Σ leftRotate(*ctxts[i], rots[i])
+    ///@param[in] ctxts
+    ///@param[in] rots
+    ///@param[out] ctxt_out
+    ///@details Same as the overload above for ciphertexts which are not
+    /// stored contiguously.
+    ///@throws RuntimeException if ctxts and rots have the different size or
+    /// are empty.
+    void rotSum(Span<const Ciphertext *const> ctxts,
+                const std::vector<u64> &rots, Ciphertext &ctxt_out) const;
 
     ///@brief Compute left Rotate Reduce of Message
     ///@param[in] msg
@@ -434,6 +646,15 @@ public:
     /// counter.
     void multWithoutRescale(const Ciphertext &ctxt1, const Plaintext &ptxt2,
                             Ciphertext &ctxt_out) const;
+    ///@brief Multiply a Ciphertext and a PreparedPlaintext without rescaling
+    ///@param[in] ctxt1
+    ///@param[in] ptxt2
+    ///@param[out] ctxt_out
+    ///@details Same as multWithoutRescale(ctxt1,
+    /// ptxt2.getPlaintext(ctxt1.getLevel()), ctxt_out).
+    void multWithoutRescale(const Ciphertext &ctxt1,
+                            const PreparedPlaintext &ptxt2,
+                            Ciphertext &ctxt_out) const;
     ///@brief Multiply two Ciphertext
     ///@param[in] ctxt1
     ///@param[in] ctxt2
@@ -446,6 +667,57 @@ public:
     void multWithoutRescale(const Ciphertext &ctxt1, const Ciphertext &ctxt2,
                             Ciphertext &ctxt_out) const;
 
+    ///@brief Compute Σ ctxts[i] * ptxts[i]
+    ///@param[in] ctxts
+    ///@param[in] ptxts
+    ///@param[out] ctxt_out
+    ///@details The products are accumulated in the NTT domain with a single
+    /// modular reduction per coefficient, and the sum is rescaled once instead
+    /// of once per product as with mult and add. Operands whose level is
+    /// higher than the lowest level among them are adjusted to that level.
+    ///@throws RuntimeException if ctxts and ptxts have the different size or
+    /// are empty.
+    ///@throws RuntimeException if any of the input operands has nonzero rescale
+    /// counter.
+    void innerProduct(Span<const Ciphertext> ctxts,
+                      Span<const Plaintext> ptxts, Ciphertext &ctxt_out) const;
+    ///@brief Compute Σ ctxts1[i] * ctxts2[i]
+    ///@param[in] ctxts1
+    ///@param[in] ctxts2
+    ///@param[out] ctxt_out
+    ///@details The tensor products of all the pairs are accumulated into a
+    /// single ciphertext of size 3 in the NTT domain, which is then
+    /// relinearized and rescaled once. Only one key switching is performed
+    /// instead of one per pair. Operands whose level is higher than the lowest
+    /// level among them are adjusted to that level.
+    ///@throws RuntimeException if ctxts1 and ctxts2 have the different size or
+    /// are empty.
+    ///@throws RuntimeException if any of the input operands has nonzero rescale
+    /// counter or size other than 2.
+    void innerProduct(Span<const Ciphertext> ctxts1,
+                      Span<const Ciphertext> ctxts2,
+                      Ciphertext &ctxt_out) const;
+    ///@brief Compute Σ *ctxts[i] * *ptxts[i]
+    ///@param[in] ctxts
+    ///@param[in] ptxts
+    ///@param[out] ctxt_out
+    ///@details Same as innerProduct(Span<const Ciphertext>,
+    /// Span<const Plaintext>, Ciphertext &) for operands which are not stored
+    /// contiguously.
+    void innerProduct(Span<const Ciphertext *const> ctxts,
+                      Span<const Plaintext *const> ptxts,
+                      Ciphertext &ctxt_out) const;
+    ///@brief Compute Σ *ctxts1[i] * *ctxts2[i]
+    ///@param[in] ctxts1
+    ///@param[in] ctxts2
+    ///@param[out] ctxt_out
+    ///@details Same as innerProduct(Span<const Ciphertext>,
+    /// Span<const Ciphertext>, Ciphertext &) for operands which are not stored
+    /// contiguously.
+    void innerProduct(Span<const Ciphertext *const> ctxts1,
+                      Span<const Ciphertext *const> ctxts2,
+                      Ciphertext &ctxt_out) const;
+
     ///@brief Compute (a1b2 + a2b1, b1b2, a1a2)
     ///@param[in] ctxt1
     ///@param[in] ctxt2
@@ -480,6 +752,24 @@ public:
     ///@throws RuntimeException if ctxt has nonzero rescale counter.
     void rescale(Ciphertext &ctxt) const;
 
+    ///@brief Divide many Ciphertext by the scale factor
+    ///@param[in, out] ctxts
+    ///@details With at least as many ciphertexts as OpenMP threads, the work is
+    /// split across threads by ciphertext rather than inside each polynomial;
+    /// with fewer, the ciphertexts are processed one after another, each with
+    /// all the threads.
+    ///@throws RuntimeException if the rescale counter of any of ctxts is not
+    /// positive.
+    void rescale(Span<Ciphertext> ctxts) const;
+    ///@brief Divide a Ciphertext by the scale factor, in place
+    ///@param[in, out] ctxt
+    ///@details Same as rescale(ctxt): the residues of the dropped prime are
+    /// folded into the remaining ones within the buffers of ctxt, without
+    /// allocation.
+    ///@throws RuntimeException if the rescale counter of ctxt is not
+    /// positive.
+    void rescaleInplace(Ciphertext &ctxt) const;
+
     ///@brief Increase one level and multiply the prime at current level + 1.
     ///@param[in, out] ptxt
     ///@details It transforms a plaintext of a level ℓ encoding a message m
@@ -513,6 +803,19 @@ public:
     ///@throws RuntimeException if ctxt has nonzero rescale counter.
     void levelDown(const Ciphertext &ctxt, u64 target_level,
                    Ciphertext &ctxt_out) const;
+    ///@brief Decrease the level of many Ciphertext
+    ///@param[in] ctxts
+    ///@param[in] target_level
+    ///@param[out] ctxts_out
+    ///@details With at least as many ciphertexts as OpenMP threads, the work is
+    /// split across threads by ciphertext rather than inside each polynomial;
+    /// with fewer, the ciphertexts are processed one after another, each with
+    /// all the threads.
+    ///@throws RuntimeException if ctxts and ctxts_out have the different size
+    ///@throws RuntimeException if target_level is greater than level of any
+    /// of ctxts
+    void levelDown(Span<const Ciphertext> ctxts, u64 target_level,
+                   Span<Ciphertext> ctxts_out) const;
     ///@brief Decrease the level of Ciphertext by one
     ///@param[in] ctxt
     ///@param[out] ctxt_out
@@ -528,6 +831,24 @@ public:
     void relevel(const Plaintext &ptxt, const u64 target_level,
                  Plaintext &ptxt_out) const;
 
+    ///@brief Warm up the allocator for the scratch memory of the threads
+    /// running the evaluator; no memory is reserved or held afterwards
+    ///@param[in] num_threads Number of threads which will call the evaluator
+    /// concurrently
+    ///@param[in] max_level Highest level of the ciphertexts they will process
+    ///@details Key switching in mult, leftRotate and conjugate allocates
+    /// temporary buffers in the extended modulus on every call, inside the
+    /// library; the evaluator owns no workspace. This runs one key switching
+    /// at max_level on each of num_threads OpenMP threads, so that the
+    /// allocator has served buffers of that size to every thread before the
+    /// hot path starts. Whether freed buffers are kept for later calls is up
+    /// to the allocator of the process, which this function leaves as it is;
+    /// see tuneAllocatorForKeySwitching().
+    ///@throws RuntimeException if num_threads is zero or if max_level exceeds
+    /// the maximal level of a ciphertext.
+    ///@throws RuntimeException if the multiplication key is not loaded.
+    void reserveWorkspace(u64 num_threads, u64 max_level) const;
+
     ///@brief Get the internal Context object.
     ///@returns The context object required.
     const Context &getContext() const { return context_; }
@@ -538,4 +859,19 @@ private:
     ///@brief Internal implementation object
     std::shared_ptr<HomEvaluatorImpl> impl_;
 };
+
+///@brief Tune the glibc allocator of the process for key switching
+///@param[in] max_arenas Upper bound on the number of malloc arenas, e.g. the
+/// number of threads calling evaluators plus one
+///@details Freed blocks of up to 32 MiB are kept in the arenas instead of
+/// being unmapped, the arenas are never trimmed, and their number is capped at
+/// max_arenas. Key switching buffers are then reused across calls rather than
+/// mapped and faulted in again, at the cost of memory which is never returned
+/// to the system. The settings apply to every thread of the process for the
+/// rest of its life, so this is meant to be called once, at startup, by an
+/// application whose threads mostly run evaluators.
+///@returns false if the allocator is not glibc or rejected a setting
+///@throws RuntimeException if max_arenas is zero.
+HEAAN_API bool tuneAllocatorForKeySwitching(u64 max_arenas);
+
 } // namespace HEaaN
@@ -0,0 +1,94 @@
+////////////////////////////////////////////////////////////////////////////////
+//                                                                            //
+// Copyright (C) 2021-2023 Crypto Lab Inc.                                    //
+//                                                                            //
+// - This file is part of HEaaN homomorphic encryption library.               //
+// - HEaaN cannot be copied and/or distributed without the express permission //
+//  of Crypto Lab Inc.                                                        //
+//                                                                            //
+////////////////////////////////////////////////////////////////////////////////
+
+#pragma once
+
+#include <string>
+#include <vector>
+
+#include "HEaaNExport.hpp"
+#include "Integers.hpp"
+#include "KeyPack.hpp"
+
+namespace HEaaN {
+
+///
+///@brief Memory-mapped access to the keys saved under a directory
+///@details A KeyStore reads the files which KeyGenerator::save and
+/// KeyPack::save write under key_dir_path + "/PK". Each key file is mapped
+/// read-only and loaded into a KeyPack straight from the mapping, so the file
+/// is not copied through a stream buffer, and the mapped pages are those of
+/// the page cache, shared by all the worker processes on a host. The mapping
+/// is dropped once the key is loaded.
+///
+/// Only the reading is shared. The loaded keys are deserialized into the
+/// KeyPack, in the private memory of each process, as with KeyPack(context,
+/// key_dir_path); the library cannot evaluate with keys it does not own. The
+/// resident memory of n worker processes therefore still holds n copies of
+/// the keys.
+///
+class HEAAN_API KeyStore {
+public:
+    ///@brief Open the keys saved under key_dir_path
+    ///@throws RuntimeException if key_dir_path + "/PK" is not a directory.
+    explicit KeyStore(const std::string &key_dir_path);
+
+    const std::string &getKeyDirPath() const { return key_dir_path_; }
+
+    ///@brief Check whether the file of the left rotation key by rot exists
+    bool hasLeftRotKey(u64 rot) const;
+
+    ///@brief Get the indices of the left rotation keys in the directory, in
+    /// increasing order
+    std::vector<u64> getLeftRotKeyIndices() const;
+
+    ///@brief Get the size in bytes of the file of the left rotation key by rot
+    ///@throws RuntimeException if there is no such file.
+    u64 getLeftRotKeySize(u64 rot) const;
+
+    ///@brief Load the encryption key into keypack
+    ///@throws RuntimeException if the key file cannot be mapped.
+    void loadEncKey(KeyPack &keypack) const;
+
+    ///@brief Load the multiplication key into keypack
+    ///@throws RuntimeException if the key file cannot be mapped.
+    void loadMultKey(KeyPack &keypack) const;
+
+    ///@brief Load the conjugation key into keypack
+    ///@throws RuntimeException if the key file cannot be mapped.
+    void loadConjKey(KeyPack &keypack) const;
+
+    ///@brief Load the left rotation key by rot into keypack
+    ///@throws RuntimeException if the key file cannot be mapped.
+    void loadLeftRotKey(KeyPack &keypack, u64 rot) const;
+
+    ///@brief Check whether the file of the sparse secret encapsulation key
+    /// exists
+    bool hasSparseSecretEncapsulationKey() const;
+
+    ///@brief Load the sparse secret encapsulation key into keypack
+    ///@details keypack should be constructed with the sparse context, i.e. by
+    /// KeyPack(context, context_sparse); the library does not check it.
+    ///@throws RuntimeException if the key file cannot be mapped.
+    void loadSparseSecretEncapsulationKey(KeyPack &keypack) const;
+
+    ///@brief Load every key found in the directory into keypack
+    ///@details If the directory holds a sparse secret encapsulation key,
+    /// keypack should be constructed with the sparse context, as in
+    /// loadSparseSecretEncapsulationKey().
+    void loadAll(KeyPack &keypack) const;
+
+private:
+    std::string getPath(const std::string &name) const;
+
+    std::string key_dir_path_;
+};
+
+} // namespace HEaaN
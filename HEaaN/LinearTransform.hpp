@@ -0,0 +1,95 @@
+////////////////////////////////////////////////////////////////////////////////
+//                                                                            //
+// Copyright (C) 2021-2023 Crypto Lab Inc.                                    //
+//                                                                            //
+// - This file is part of HEaaN homomorphic encryption library.               //
+// - HEaaN cannot be copied and/or distributed without the express permission //
+//  of Crypto Lab Inc.                                                        //
+//                                                                            //
+////////////////////////////////////////////////////////////////////////////////
+
+#pragma once
+
+#include <map>
+#include <utility>
+#include <vector>
+
+#include "HEaaNExport.hpp"
+#include "HomEvaluator.hpp"
+#include "Plaintext.hpp"
+#include "Real.hpp"
+
+namespace HEaaN {
+
+class Ciphertext;
+
+///
+///@brief A plaintext matrix which is multiplied to encrypted vectors with the
+/// baby-step giant-step (BSGS) algorithm
+///@details The matrix M of size n = 2^log_slots is stored as its nonzero
+/// generalized diagonals d_k[j] = M[j][(j + k) mod n]. Writing k = g * b + i
+/// for the baby step b, the product is evaluated as
+/// Σ_g rot_{g b}(Σ_i rot_{-g b}(d_k) ⊙ rot_i(x)), so that a dense matrix needs
+/// about 2√n rotations instead of n.
+///
+class HEAAN_API LinearTransform {
+public:
+    using Matrix = std::vector<std::vector<Complex>>;
+
+    ///@brief Encode the nonzero diagonals of a matrix
+    ///@param[in] eval HomEvaluator used to apply the transform
+    ///@param[in] matrix Square matrix whose size is the number of slots of the
+    /// ciphertexts to be transformed
+    ///@param[in] level Level of the ciphertexts to be transformed, at which the
+    /// diagonals are encoded
+    ///@details The baby step is chosen among the powers of two so that the
+    /// total number of rotations for the nonzero diagonals is minimal.
+    ///@throws RuntimeException if matrix is not square, if its size is not a
+    /// power of two, or if it exceeds the number of full slots.
+    ///@throws RuntimeException if level is zero or exceeds the encryption
+    /// level.
+    explicit LinearTransform(const HomEvaluator &eval, const Matrix &matrix,
+                             u64 level);
+
+    ///@brief Get the rotation indices the transform needs
+    ///@returns Sorted left rotation indices to be passed to
+    /// KeyGenerator::genLeftRotationKey before calling apply()
+    std::vector<u64> getRotationIndices() const;
+
+    ///@brief Get log(number of slots) of the transformed ciphertexts
+    u64 getLogSlots() const { return log_slots_; }
+
+    ///@brief Get the level at which the diagonals are encoded
+    u64 getLevel() const { return level_; }
+
+    ///@brief Get the baby step b of the BSGS decomposition
+    u64 getBabyStep() const { return baby_step_; }
+
+    ///@brief Get the number of nonzero diagonals of the matrix
+    u64 getNumDiagonals() const;
+
+    ///@brief Multiply the matrix to the vector which ctxt encrypts
+    ///@param[in] ctxt
+    ///@param[out] ctxt_out
+    ///@details The input is brought down to getLevel() if it is above it, and
+    /// the output is one level lower. Baby-step rotations are computed once
+    /// with the multi-rotation leftRotate, and every giant step is a single
+    /// innerProduct followed by one rotation.
+    ///@throws RuntimeException if the number of slots of ctxt differs from the
+    /// size of the matrix, or if ctxt has nonzero rescale counter.
+    void apply(const Ciphertext &ctxt, Ciphertext &ctxt_out) const;
+
+private:
+    ///@brief Evaluator to which the transform is bound
+    const HomEvaluator eval_;
+    u64 log_slots_;
+    u64 level_;
+    u64 baby_step_;
+    ///@brief Baby-step indices i such that some d_{g b + i} is nonzero
+    std::vector<u64> baby_indices_;
+    ///@brief For each giant index g, the baby indices i and the encodings of
+    /// rot_{-g b}(d_{g b + i})
+    std::map<u64, std::vector<std::pair<u64, Plaintext>>> diagonals_;
+};
+
+} // namespace HEaaN
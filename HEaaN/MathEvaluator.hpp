@@ -0,0 +1,127 @@
+////////////////////////////////////////////////////////////////////////////////
+//                                                                            //
+// Copyright (C) 2021-2023 Crypto Lab Inc.                                    //
+//                                                                            //
+// - This file is part of HEaaN homomorphic encryption library.               //
+// - HEaaN cannot be copied and/or distributed without the express permission //
+//  of Crypto Lab Inc.                                                        //
+//                                                                            //
+////////////////////////////////////////////////////////////////////////////////
+
+#pragma once
+
+#include <vector>
+
+#include "Bootstrapper.hpp"
+#include "HEaaNExport.hpp"
+#include "HomEvaluator.hpp"
+#include "Integers.hpp"
+#include "PolynomialEvaluator.hpp"
+#include "Real.hpp"
+
+namespace HEaaN {
+
+class Ciphertext;
+
+///@brief Input range and precision of the functions of MathEvaluator
+struct MathConfig {
+    ///@brief Lower bound of the inputs, which should be positive
+    Real min_value = REAL_ONE / 1024;
+    ///@brief Upper bound of the inputs
+    Real max_value = REAL_ONE;
+    ///@brief Target relative error 2^-log_error, on top of the approximation
+    /// error of the scheme
+    u64 log_error = 16;
+};
+
+///
+///@brief A class computing 1/x, sqrt(x) and 1/sqrt(x) on encrypted positive
+/// real numbers
+///@details Each function starts from a Chebyshev approximation of the target
+/// on [min_value, max_value] and refines it with Goldschmidt iterations:
+///  - inverse: y <- y (1 + e), e <- e^2 with e = 1 - x y, one level per
+///    iteration;
+///  - sqrt and invSqrt: r = 1/2 - g h, g <- g (1 + r), h <- h (1 + r) with
+///    g -> sqrt(x) and h -> 1/(2 sqrt(x)), two levels per iteration.
+///
+/// The degree of the approximation and the number of iterations are planned
+/// at construction so that the total depth for the requested precision is
+/// minimal. When the levels run out, only the estimate (y or h) is
+/// bootstrapped and the error term is recomputed from the input, so each
+/// refresh costs a single bootstrap. Bootstrapper::bootstrapExtended is used
+/// only for values which may leave [-1, 1].
+///
+class HEAAN_API MathEvaluator {
+public:
+    ///@param[in] eval
+    ///@param[in] btp Bootstrapper whose constants are ready for the number of
+    /// slots of the inputs
+    ///@param[in] config
+    ///@throws RuntimeException if the range is empty, not positive, or if the
+    /// values involved exceed the range of bootstrapExtended.
+    ///@throws RuntimeException if log_error is zero or larger than 40.
+    explicit MathEvaluator(const HomEvaluator &eval, const Bootstrapper &btp,
+                           const MathConfig &config = MathConfig());
+
+    ///@brief Get the number of levels inverse() consumes without bootstrap
+    u64 getInverseDepth() const;
+
+    ///@brief Get the number of Goldschmidt iterations of inverse()
+    u64 getNumInverseIterations() const { return inverse_.num_iters; }
+
+    ///@brief Get the number of levels sqrt() and invSqrt() consume without
+    /// bootstrap
+    u64 getSqrtDepth() const;
+
+    ///@brief Get the number of Goldschmidt iterations of sqrt() and invSqrt()
+    u64 getNumSqrtIterations() const { return inv_sqrt_.num_iters; }
+
+    ///@brief Compute 1/x for each slot
+    ///@param[in] ctxt Ciphertext encrypting real numbers in the range of the
+    /// MathConfig
+    ///@param[out] ctxt_out
+    ///@details The input is bootstrapped first only if its level is less
+    /// than getInverseDepth().
+    ///@throws RuntimeException if ctxt has nonzero rescale counter.
+    ///@throws RuntimeException if a bootstrap is needed but the level of ctxt
+    /// is too low for it.
+    void inverse(const Ciphertext &ctxt, Ciphertext &ctxt_out) const;
+
+    ///@brief Compute sqrt(x) for each slot
+    ///@details See inverse() for the inputs and bootstrapping.
+    ///@throws RuntimeException as in inverse().
+    void sqrt(const Ciphertext &ctxt, Ciphertext &ctxt_out) const;
+
+    ///@brief Compute 1/sqrt(x) for each slot
+    ///@details See inverse() for the inputs and bootstrapping.
+    ///@throws RuntimeException as in inverse().
+    void invSqrt(const Ciphertext &ctxt, Ciphertext &ctxt_out) const;
+
+private:
+    ///@brief Initial Chebyshev approximation and number of iterations
+    struct Approximation {
+        std::vector<Real> coeffs;
+        u64 num_iters;
+    };
+
+    void bootstrap(const Ciphertext &ctxt, Real max_abs,
+                   Ciphertext &ctxt_out) const;
+    u64 minLevelForBootstrap(Real max_abs) const;
+    void prepareInput(const Ciphertext &ctxt, u64 depth,
+                      Ciphertext &ctxt_out) const;
+    void approximate(const Ciphertext &ctxt, const Approximation &approx,
+                     Ciphertext &ctxt_out) const;
+    void sqrtIterations(const Ciphertext &ctxt, bool want_sqrt,
+                        Ciphertext &ctxt_out) const;
+
+    const HomEvaluator eval_;
+    const Bootstrapper btp_;
+    PolynomialEvaluator poly_eval_;
+    MathConfig config_;
+    ///@brief Approximation of 1/x
+    Approximation inverse_;
+    ///@brief Approximation of 1/(2 sqrt(x))
+    Approximation inv_sqrt_;
+};
+
+} // namespace HEaaN
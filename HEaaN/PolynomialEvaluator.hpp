@@ -0,0 +1,88 @@
+////////////////////////////////////////////////////////////////////////////////
+//                                                                            //
+// Copyright (C) 2021-2023 Crypto Lab Inc.                                    //
+//                                                                            //
+// - This file is part of HEaaN homomorphic encryption library.               //
+// - HEaaN cannot be copied and/or distributed without the express permission //
+//  of Crypto Lab Inc.                                                        //
+//                                                                            //
+////////////////////////////////////////////////////////////////////////////////
+
+#pragma once
+
+#include <vector>
+
+#include "HEaaNExport.hpp"
+#include "HomEvaluator.hpp"
+#include "PowerBasis.hpp"
+#include "Real.hpp"
+
+namespace HEaaN {
+
+class Ciphertext;
+
+///
+///@brief A class evaluating polynomials on Ciphertext with the
+/// Paterson-Stockmeyer algorithm
+///@details A polynomial p is split recursively as p = q * x^(2^j) + r (or
+/// q * T_(2^j) + r in the Chebyshev basis) down to leaves whose terms are
+/// multiplied by scalars. The baby-step bound and the split points are planned
+/// from the degree so that the multiplicative depth is ceil(log2(degree + 1))
+/// with as few non-scalar multiplications as possible under that depth.
+/// Powers are taken from a PowerBasis, which may be shared by several
+/// evaluations on the same input.
+///
+class HEAAN_API PolynomialEvaluator {
+public:
+    explicit PolynomialEvaluator(const HomEvaluator &eval);
+
+    ///@brief Get the number of levels consumed by evaluate()
+    ///@param[in] degree Degree of the polynomial
+    ///@returns ceil(log2(degree + 1))
+    static u64 getDepth(u64 degree);
+
+    ///@brief Get the number of non-scalar multiplications evaluate() performs
+    /// for a dense polynomial of given degree
+    ///@param[in] degree Degree of the polynomial
+    ///@param[in] basis
+    ///@details Multiplications are counted for both the powers and the
+    /// recombination of the leaves. Zero coefficients can only lower the
+    /// actual count.
+    static u64 getNumNonScalarMults(u64 degree, PolynomialBasis basis);
+
+    ///@brief Evaluate a polynomial on the message which ctxt encrypts
+    ///@param[in] ctxt
+    ///@param[in] coeffs Coefficients of the polynomial, from the constant term
+    /// up to the leading one
+    ///@param[in] basis
+    ///@param[out] ctxt_out
+    ///@details ctxt_out is getDepth(degree) levels below ctxt, where degree
+    /// ignores trailing zero coefficients.
+    ///@throws RuntimeException if coeffs is empty
+    ///@throws RuntimeException if ctxt has nonzero rescale counter.
+    ///@throws RuntimeException if the level of ctxt is less than the depth
+    /// of the polynomial.
+    void evaluate(const Ciphertext &ctxt, const std::vector<Real> &coeffs,
+                  PolynomialBasis basis, Ciphertext &ctxt_out) const;
+
+    ///@brief Evaluate a polynomial on the input of a power basis
+    ///@param[in] powers Powers of the input, in the basis of coeffs
+    ///@param[in] coeffs Coefficients of the polynomial, from the constant term
+    /// up to the leading one
+    ///@param[out] ctxt_out
+    ///@details The powers the evaluation needs, including the copies brought
+    /// down to the level of each leaf, are computed through powers and stay
+    /// cached there for later evaluations. ctxt_out is getDepth(degree) levels
+    /// below powers.getInput().
+    ///@throws RuntimeException if coeffs is empty
+    ///@throws RuntimeException if the level of the input of powers is less
+    /// than the depth of the polynomial.
+    void evaluate(PowerBasis &powers, const std::vector<Real> &coeffs,
+                  Ciphertext &ctxt_out) const;
+
+private:
+    ///@brief Evaluator used for the homomorphic operations
+    const HomEvaluator eval_;
+};
+
+} // namespace HEaaN
@@ -0,0 +1,131 @@
+////////////////////////////////////////////////////////////////////////////////
+//                                                                            //
+// Copyright (C) 2021-2023 Crypto Lab Inc.                                    //
+//                                                                            //
+// - This file is part of HEaaN homomorphic encryption library.               //
+// - HEaaN cannot be copied and/or distributed without the express permission //
+//  of Crypto Lab Inc.                                                        //
+//                                                                            //
+////////////////////////////////////////////////////////////////////////////////
+
+#pragma once
+
+#include <list>
+#include <map>
+#include <memory>
+#include <utility>
+
+#include "Ciphertext.hpp"
+#include "HEaaNExport.hpp"
+#include "HomEvaluator.hpp"
+#include "Integers.hpp"
+
+namespace HEaaN {
+
+///@brief Basis in which the coefficients of a polynomial are given
+enum class PolynomialBasis {
+    ///@brief Σ c_i x^i
+    MONOMIAL,
+    ///@brief Σ c_i T_i(x) where T_i is the i-th Chebyshev polynomial of the
+    /// first kind. The input should lie in [-1, 1].
+    CHEBYSHEV,
+};
+
+///
+///@brief A cache of the powers x, x^2, x^3, ... (or T_1(x), T_2(x), ...) of an
+/// encrypted input
+///@details Powers are computed on demand with HomEvaluator::square and
+/// HomEvaluator::mult, so that x^i is getPowerDepth(i) levels below the input,
+/// and are kept for later requests. Copies brought down to lower levels are
+/// cached as well, keyed by level. Several polynomials evaluated on the same
+/// input through PolynomialEvaluator therefore share all of their powers.
+///
+/// When a memory budget is set, the least recently used powers are dropped
+/// once the cached ciphertexts exceed it, and are recomputed if requested
+/// again. Powers are handed out as shared pointers, so a dropped power stays
+/// valid for as long as the caller holds it. The input itself is always kept
+/// and is not counted against the budget.
+///
+/// A PowerBasis is not thread-safe.
+///
+class HEAAN_API PowerBasis {
+public:
+    ///@param[in] eval Evaluator used to compute the powers
+    ///@param[in] ctxt Input x
+    ///@param[in] basis Whether x^i or T_i(x) is computed
+    ///@param[in] memory_budget Upper bound in bytes on the cached powers, or
+    /// zero for no bound
+    ///@throws RuntimeException if ctxt has nonzero rescale counter.
+    explicit PowerBasis(const HomEvaluator &eval, const Ciphertext &ctxt,
+                        PolynomialBasis basis = PolynomialBasis::MONOMIAL,
+                        u64 memory_budget = 0);
+
+    ///@brief Get the number of levels x^i is below the input
+    ///@returns ceil(log2(idx))
+    static u64 getPowerDepth(u64 idx);
+
+    ///@brief Get x^idx (or T_idx(x)) at getInput().getLevel() -
+    /// getPowerDepth(idx)
+    ///@throws RuntimeException if idx is zero or if the input level is less
+    /// than getPowerDepth(idx).
+    std::shared_ptr<const Ciphertext> getPower(u64 idx);
+
+    ///@brief Get x^idx (or T_idx(x)) at a given level
+    ///@param[in] idx
+    ///@param[in] level Level not above that of getPower(idx)
+    ///@throws RuntimeException if level is above that of getPower(idx).
+    std::shared_ptr<const Ciphertext> getPower(u64 idx, u64 level);
+
+    ///@brief Get the input x
+    const Ciphertext &getInput() const { return *input_; }
+
+    ///@brief Get the basis of the powers
+    PolynomialBasis getBasis() const { return basis_; }
+
+    ///@brief Get the evaluator computing the powers
+    const HomEvaluator &getHomEvaluator() const { return eval_; }
+
+    ///@brief Get the memory budget in bytes, zero meaning no bound
+    u64 getMemoryBudget() const { return memory_budget_; }
+
+    ///@brief Set the memory budget in bytes, zero meaning no bound
+    ///@details Cached powers are dropped right away to fit a smaller budget.
+    void setMemoryBudget(u64 memory_budget);
+
+    ///@brief Get the bytes held by the cached powers
+    ///@details A ciphertext is accounted for by the residues it holds at its
+    /// level, i.e. size * (level + 1) * N words.
+    u64 getMemoryUsage() const { return memory_usage_; }
+
+    ///@brief Get the number of cached powers, counting each level separately
+    u64 getNumCachedPowers() const { return cache_.size(); }
+
+    ///@brief Drop all cached powers except the input
+    void clear();
+
+private:
+    using Key = std::pair<u64, u64>;
+    struct Entry {
+        std::shared_ptr<const Ciphertext> ctxt;
+        u64 bytes;
+        std::list<Key>::iterator lru_pos;
+    };
+
+    std::shared_ptr<const Ciphertext> lookup(const Key &key);
+    std::shared_ptr<const Ciphertext> insert(const Key &key,
+                                             Ciphertext &&ctxt);
+    void evictToBudget();
+
+    ///@brief Evaluator used for the homomorphic operations
+    const HomEvaluator eval_;
+    std::shared_ptr<const Ciphertext> input_;
+    PolynomialBasis basis_;
+    u64 memory_budget_;
+    u64 memory_usage_;
+    ///@brief Cached powers keyed by (index, level)
+    std::map<Key, Entry> cache_;
+    ///@brief Keys of cache_ from the most to the least recently used
+    std::list<Key> lru_;
+};
+
+} // namespace HEaaN
@@ -0,0 +1,111 @@
+////////////////////////////////////////////////////////////////////////////////
+//                                                                            //
+// Copyright (C) 2021-2023 Crypto Lab Inc.                                    //
+//                                                                            //
+// - This file is part of HEaaN homomorphic encryption library.               //
+// - HEaaN cannot be copied and/or distributed without the express permission //
+//  of Crypto Lab Inc.                                                        //
+//                                                                            //
+////////////////////////////////////////////////////////////////////////////////
+
+#pragma once
+
+#include <map>
+#include <memory>
+#include <mutex>
+
+#include "EnDecoder.hpp"
+#include "HEaaNExport.hpp"
+#include "HomEvaluator.hpp"
+#include "Integers.hpp"
+#include "Message.hpp"
+#include "Plaintext.hpp"
+
+namespace HEaaN {
+
+///
+///@brief A constant operand prepared once and materialized as a Plaintext at
+/// each level on first use
+///@details A PreparedPlaintext holds one canonical form of a constant, either
+/// the Message itself or a Plaintext at some level. getPlaintext(level) encodes
+/// the message, or relevels the plaintext, the first time a level is asked
+/// for, and keeps the result for later requests at that level. The same
+/// weights can then be used with ciphertexts at any level without encoding
+/// them once per level up front or calling HomEvaluator::relevel on every
+/// operation.
+///
+/// Encoding a message is cheaper than releveling a plaintext, and a message
+/// takes a fraction of the memory of a plaintext at a high level, so the
+/// message is the preferred canonical form. Materialized levels can be dropped
+/// with clear() when memory is short.
+///
+/// Materialized plaintexts hold residues only, without Shoup companion words.
+/// The library multiplies a ciphertext by a plaintext or a constant with
+/// vectorized kernels bound by memory bandwidth. A companion word per residue
+/// adds a third input stream, and a portable Shoup kernel measured slower than
+/// those kernels, so HomEvaluator has no prepared-operand multiplication.
+///
+/// A PreparedPlaintext may be shared by several threads.
+///
+class HEAAN_API PreparedPlaintext {
+public:
+    ///@brief Prepare a message
+    ///@param[in] eval Evaluator whose Context the plaintexts belong to
+    ///@param[in] msg Canonical form
+    ///@param[in] r_counter Rescale counter of the plaintexts
+    ///@throws RuntimeException if msg is empty.
+    explicit PreparedPlaintext(const HomEvaluator &eval, const Message &msg,
+                               int r_counter = 0);
+
+    ///@brief Prepare a plaintext
+    ///@param[in] eval Evaluator used to relevel ptxt
+    ///@param[in] ptxt Canonical form, which also serves its own level
+    ///@details Plaintexts are available at the level of ptxt and below.
+    explicit PreparedPlaintext(const HomEvaluator &eval, const Plaintext &ptxt);
+
+    ///@brief Get the plaintext at a level
+    ///@param[in] level
+    ///@details The plaintext is materialized on the first request for level
+    /// and shared by the later ones.
+    ///@throws RuntimeException if level exceeds getMaxLevel().
+    std::shared_ptr<const Plaintext> getPlaintext(u64 level) const;
+
+    ///@brief Get the highest level at which plaintexts are available
+    u64 getMaxLevel() const { return max_level_; }
+
+    ///@brief Get the rescale counter of the plaintexts
+    int getRescaleCounter() const { return r_counter_; }
+
+    ///@brief Get log(number of slots) of the plaintexts
+    u64 getLogSlots() const { return log_slots_; }
+
+    ///@brief Get the number of levels materialized so far
+    u64 getNumMaterializedLevels() const;
+
+    ///@brief Get the bytes held by the materialized plaintexts
+    ///@details A plaintext is accounted for by the residues it holds at its
+    /// level, i.e. (level + 1) * N words. The canonical form is not counted.
+    u64 getMemoryUsage() const;
+
+    ///@brief Drop the materialized plaintexts other than the canonical one
+    void clear();
+
+private:
+    Plaintext materialize(u64 level) const;
+
+    ///@brief Evaluator used to relevel the canonical plaintext
+    const HomEvaluator eval_;
+    const EnDecoder encoder_;
+    ///@brief Canonical message, empty if the canonical form is a plaintext
+    Message msg_;
+    ///@brief Canonical plaintext, null if the canonical form is a message
+    std::shared_ptr<const Plaintext> ptxt_;
+    u64 max_level_;
+    int r_counter_;
+    u64 log_slots_;
+    mutable std::mutex mutex_;
+    ///@brief Materialized plaintexts keyed by level
+    mutable std::map<u64, std::shared_ptr<const Plaintext>> levels_;
+};
+
+} // namespace HEaaN
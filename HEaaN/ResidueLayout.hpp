@@ -0,0 +1,105 @@
+////////////////////////////////////////////////////////////////////////////////
+//                                                                            //
+// Copyright (C) 2021-2023 Crypto Lab Inc.                                    //
+//                                                                            //
+// - This file is part of HEaaN homomorphic encryption library.               //
+// - HEaaN cannot be copied and/or distributed without the express permission //
+//  of Crypto Lab Inc.                                                        //
+//                                                                            //
+////////////////////////////////////////////////////////////////////////////////
+
+#pragma once
+
+#include <vector>
+
+#include "Ciphertext.hpp"
+#include "Context.hpp"
+#include "HEaaNExport.hpp"
+#include "Integers.hpp"
+#include "Plaintext.hpp"
+#include "Span.hpp"
+
+namespace HEaaN {
+
+///
+///@brief Direct access to the residue arrays of ciphertexts and plaintexts
+/// for I/O without intermediate copies
+///@details The residues of a ciphertext are ordered by polynomial and, within
+/// a polynomial, by level from 0 up to getLevel(), N words each. The same
+/// order is used for flat buffers, which hold getFlatSize() words.
+///
+/// getResidues() gives the arrays of a ciphertext in place, e.g. as the
+/// iovecs of writev, and prepareResidues() shapes a ciphertext and gives its
+/// arrays to be filled, e.g. by readv, so that data moves between a socket
+/// and the evaluator with a single copy. Arrays which happen to be adjacent
+/// in memory are merged, so the number of spans may be smaller than size *
+/// (level + 1).
+///
+/// Only the residues are covered; the size, level, rescale counter and
+/// log(number of slots) are left to the caller to send along. As those may
+/// come from a peer, a size other than 2 or 3 (between tensor and
+/// relinearize) and a level above the maximal level of the context are
+/// rejected before anything is allocated.
+///
+class HEAAN_API ResidueLayout {
+public:
+    explicit ResidueLayout(const Context &context);
+
+    ///@brief Get the dimension N, the number of words per residue array
+    u64 getDegree() const { return degree_; }
+
+    ///@brief Get the number of words of a flat buffer for size polynomials at
+    /// level
+    u64 getFlatSize(u64 size, u64 level) const {
+        return size * (level + 1) * degree_;
+    }
+
+    ///@brief Get the residue arrays of a ciphertext
+    ///@throws RuntimeException if ctxt does not reside on CPU or is a mod-up
+    /// ciphertext.
+    std::vector<Span<const u64>> getResidues(const Ciphertext &ctxt) const;
+
+    ///@brief Get the residue arrays of a plaintext
+    ///@throws RuntimeException if ptxt does not reside on CPU.
+    std::vector<Span<const u64>> getResidues(const Plaintext &ptxt) const;
+
+    ///@brief Set the size and level of a ciphertext and get its residue arrays
+    /// to be written
+    ///@param[in,out] ctxt A ciphertext on CPU, which gains the memory it lacks
+    ///@param[in] size
+    ///@param[in] level
+    ///@throws RuntimeException if ctxt does not reside on CPU.
+    ///@throws RuntimeException if size is not 2 or 3, or if level exceeds the
+    /// maximal level of the context.
+    std::vector<Span<u64>> prepareResidues(Ciphertext &ctxt, u64 size,
+                                           u64 level) const;
+
+    ///@brief Set the level of a plaintext and get its residue arrays to be
+    /// written
+    ///@throws RuntimeException if ptxt does not reside on CPU.
+    ///@throws RuntimeException if level exceeds the maximal level of the
+    /// context.
+    std::vector<Span<u64>> prepareResidues(Plaintext &ptxt, u64 level) const;
+
+    ///@brief Copy the residues of a ciphertext into a flat buffer
+    ///@throws RuntimeException if out does not hold getFlatSize(size, level)
+    /// words.
+    void exportFlat(const Ciphertext &ctxt, Span<u64> out) const;
+
+    ///@brief Copy a flat buffer into the residues of a ciphertext of size
+    /// polynomials at level
+    ///@throws RuntimeException if size is not 2 or 3, or if level exceeds the
+    /// maximal level of the context.
+    ///@throws RuntimeException if in does not hold getFlatSize(size, level)
+    /// words.
+    void importFlat(Span<const u64> in, u64 size, u64 level,
+                    Ciphertext &ctxt) const;
+
+private:
+    u64 degree_;
+    ///@brief Maximal level of a ciphertext, one below the number of default
+    /// scale factors
+    u64 max_level_;
+};
+
+} // namespace HEaaN
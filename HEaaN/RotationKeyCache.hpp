@@ -0,0 +1,132 @@
+////////////////////////////////////////////////////////////////////////////////
+//                                                                            //
+// Copyright (C) 2021-2023 Crypto Lab Inc.                                    //
+//                                                                            //
+// - This file is part of HEaaN homomorphic encryption library.               //
+// - HEaaN cannot be copied and/or distributed without the express permission //
+//  of Crypto Lab Inc.                                                        //
+//                                                                            //
+////////////////////////////////////////////////////////////////////////////////
+
+#pragma once
+
+#include <chrono>
+#include <future>
+#include <list>
+#include <memory>
+#include <mutex>
+#include <unordered_map>
+
+#include "Ciphertext.hpp"
+#include "Context.hpp"
+#include "HEaaNExport.hpp"
+#include "HomEvaluator.hpp"
+#include "Integers.hpp"
+#include "KeyStore.hpp"
+
+namespace HEaaN {
+
+///
+///@brief Rotation keys loaded on demand from a KeyStore within a memory
+/// budget
+///@details A KeyPack keeps every rotation key it has loaded until it is
+/// destroyed, so a workload touching many rotations either preloads them all
+/// or grows to hold them all. A RotationKeyCache loads the left rotation key
+/// which a rotation needs the first time it is needed, and drops the least
+/// recently used keys once the loaded keys exceed the memory budget.
+///
+/// Each key is held in its own KeyPack with a HomEvaluator over it, so that
+/// dropping a key frees its memory. A key in use by a rotation stays valid
+/// until that rotation returns, and the key used last is never dropped, so a
+/// budget smaller than one key holds exactly one.
+///
+/// A RotationKeyCache may be shared by several threads. A key is loaded once
+/// however many threads ask for it at once; the others wait for that load.
+///
+class HEAAN_API RotationKeyCache {
+public:
+    ///@param[in] context Context of the keys
+    ///@param[in] store Directory of the keys
+    ///@param[in] memory_budget Upper bound in bytes on the loaded keys, or zero
+    /// for no bound
+    explicit RotationKeyCache(const Context &context, const KeyStore &store,
+                              u64 memory_budget = 0);
+
+    ///@brief Rotate ctxt left by rot, loading the key it needs if necessary
+    ///@throws RuntimeException if the key store has no key for the rotation.
+    ///@throws RuntimeException if HomEvaluator::leftRotate throws.
+    void leftRotate(const Ciphertext &ctxt, u64 rot, Ciphertext &ctxt_out);
+
+    ///@brief Rotate ctxt right by rot, loading the key it needs if necessary
+    ///@details A right rotation by rot uses the left rotation key by
+    /// (number of slots - rot).
+    ///@throws RuntimeException if the key store has no key for the rotation.
+    ///@throws RuntimeException if HomEvaluator::rightRotate throws.
+    void rightRotate(const Ciphertext &ctxt, u64 rot, Ciphertext &ctxt_out);
+
+    ///@brief Get an evaluator holding the left rotation key by rot
+    ///@details The evaluator holds no other key. It keeps the key alive after
+    /// the key is dropped from the cache.
+    ///@throws RuntimeException if the key store has no key for rot.
+    std::shared_ptr<const HomEvaluator> getEvaluator(u64 rot);
+
+    ///@brief Get the memory budget in bytes, zero meaning no bound
+    u64 getMemoryBudget() const;
+
+    ///@brief Set the memory budget in bytes, zero meaning no bound
+    ///@details Loaded keys are dropped right away to fit a smaller budget.
+    void setMemoryBudget(u64 memory_budget);
+
+    ///@brief Get the bytes held by the loaded keys
+    ///@details A key is accounted for by the size of its file.
+    u64 getMemoryUsage() const;
+
+    ///@brief Get the number of loaded keys
+    u64 getNumLoadedKeys() const;
+
+    ///@brief Get the number of key requests served by a loaded key or by a
+    /// load already in progress
+    u64 getNumHits() const;
+
+    ///@brief Get the number of key requests which loaded the key
+    u64 getNumMisses() const;
+
+    ///@brief Get the total time spent loading keys
+    std::chrono::nanoseconds getLoadTime() const;
+
+    ///@brief Drop all loaded keys and reset the counters
+    ///@details Loads in progress are not interrupted; their keys are kept
+    /// once loaded.
+    void clear();
+
+private:
+    struct Entry {
+        std::shared_ptr<const HomEvaluator> eval;
+        u64 bytes;
+        std::list<u64>::iterator lru_pos;
+    };
+
+    using EvaluatorFuture =
+        std::shared_future<std::shared_ptr<const HomEvaluator>>;
+
+    std::shared_ptr<const HomEvaluator> loadEvaluator(u64 rot);
+    void evictToBudget();
+
+    const Context context_;
+    const KeyStore store_;
+    mutable std::mutex mutex_;
+    u64 memory_budget_;
+    u64 memory_usage_;
+    u64 num_hits_;
+    u64 num_misses_;
+    std::chrono::nanoseconds load_time_;
+    ///@brief Loaded keys by rotation index
+    std::unordered_map<u64, Entry> cache_;
+    ///@brief Rotation indices of cache_ from the most to the least recently
+    /// used
+    std::list<u64> lru_;
+    ///@brief Loads in progress by rotation index
+    std::unordered_map<u64, EvaluatorFuture> loading_;
+};
+
+} // namespace HEaaN
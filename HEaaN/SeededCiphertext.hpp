@@ -0,0 +1,141 @@
+////////////////////////////////////////////////////////////////////////////////
+//                                                                            //
+// Copyright (C) 2021-2023 Crypto Lab Inc.                                    //
+//                                                                            //
+// - This file is part of HEaaN homomorphic encryption library.               //
+// - HEaaN cannot be copied and/or distributed without the express permission //
+//  of Crypto Lab Inc.                                                        //
+//                                                                            //
+////////////////////////////////////////////////////////////////////////////////
+
+#pragma once
+
+#include <istream>
+#include <memory>
+#include <ostream>
+#include <string>
+#include <vector>
+
+#include "Ciphertext.hpp"
+#include "Context.hpp"
+#include "HEaaNExport.hpp"
+#include "Integers.hpp"
+#include "Message.hpp"
+#include "Randomseeds.hpp"
+#include "SecretKey.hpp"
+
+namespace HEaaN {
+
+namespace detail {
+class NTT;
+} // namespace detail
+
+///
+///@brief A fresh secret key ciphertext whose uniform part is kept as a seed
+///@details A symmetric encryption (b, a) = (-as + e + m, a) has a uniformly
+/// random a, which SeededEncryptor derives from a 32-byte seed. Until the
+/// ciphertext is used, only the seed and b need to be kept or sent, which is
+/// about half of what Ciphertext::save writes. expand() regenerates a from
+/// the seed and gives a Ciphertext for HomEvaluator, e.g. on the server after
+/// an upload.
+///
+/// The seed is public; a does not need to be kept secret and expanding a
+/// SeededCiphertext does not require any key.
+///
+class HEAAN_API SeededCiphertext {
+    friend class SeededEncryptor;
+
+public:
+    explicit SeededCiphertext(const Context &context);
+
+    ///@brief Get the seed of the uniform part
+    const SeedType &getSeed() const { return seed_; }
+
+    ///@brief Get level of the ciphertext
+    u64 getLevel() const { return level_; }
+
+    ///@brief Get the rescale counter of the ciphertext
+    int getRescaleCounter() const { return r_counter_; }
+
+    ///@brief Get log(number of slots) of the ciphertext
+    u64 getLogSlots() const { return log_slots_; }
+
+    ///@brief Regenerate the uniform part and write the full ciphertext
+    ///@param[out] ctxt A ciphertext of size 2 on CPU
+    ///@throws RuntimeException if the ciphertext is empty, i.e. neither
+    /// encrypted nor loaded.
+    void expand(Ciphertext &ctxt) const;
+
+    ///@brief Save the seed and b to a stream
+    ///@throws RuntimeException if the ciphertext is empty.
+    void save(std::ostream &stream) const;
+
+    ///@brief Save the seed and b to a file
+    ///@throws RuntimeException if the ciphertext is empty or the file cannot
+    /// be opened.
+    void save(const std::string &path) const;
+
+    ///@brief Load a ciphertext saved by save()
+    ///@details The ciphertext is left unchanged if loading fails.
+    ///@throws RuntimeException if the stream does not hold a seeded ciphertext
+    /// of the dimension, levels, number of slots and primes of the context,
+    /// with a nonnegative rescale counter.
+    void load(std::istream &stream);
+
+    ///@brief Load a ciphertext saved by save() from a file
+    ///@throws RuntimeException if the file cannot be opened or does not hold
+    /// a seeded ciphertext fitting the context, as in load(std::istream &).
+    void load(const std::string &path);
+
+private:
+    Context context_;
+    SeedType seed_{};
+    u64 level_{0};
+    int r_counter_{0};
+    u64 log_slots_{0};
+    ///@brief Residues of b in evaluation form, N words per level from 0 up
+    std::vector<u64> b_;
+};
+
+///
+///@brief Encryptor producing SeededCiphertext with a secret key
+///@details Ciphertexts are computed on CPU outside the library with the
+/// forward transform the library keeps ciphertexts in, so that expand() gives
+/// the same Ciphertext as Encryptor::encrypt would for the same a and error.
+/// Every ciphertext draws a new seed from std::random_device, and its error,
+/// a rounded Gaussian of standard deviation 3.2, from a separate secret
+/// stream.
+///
+class HEAAN_API SeededEncryptor {
+public:
+    ///@brief Prepare the secret key in evaluation form up to the encryption
+    /// level of context
+    ///@throws RuntimeException if sk does not reside on CPU.
+    explicit SeededEncryptor(const Context &context, const SecretKey &sk);
+
+    ///@brief Encrypt a message to the encryption level, to rescale counter
+    /// zero
+    ///@param[in] msg
+    ///@param[out] ctxt
+    ///@throws RuntimeException if msg does not reside on CPU.
+    void encrypt(const Message &msg, SeededCiphertext &ctxt) const;
+
+    ///@brief Encrypt a message to a certain level, to a certain rescale
+    /// counter
+    ///@param[in] msg
+    ///@param[out] ctxt
+    ///@param[in] level
+    ///@param[in] r_counter
+    ///@throws RuntimeException if msg does not reside on CPU.
+    ///@throws RuntimeException if level exceeds the encryption level.
+    void encrypt(const Message &msg, SeededCiphertext &ctxt, u64 level,
+                 int r_counter = 0) const;
+
+private:
+    Context context_;
+    std::vector<std::shared_ptr<const detail::NTT>> ntts_;
+    ///@brief s in evaluation form, one vector per level
+    std::vector<std::vector<u64>> sx_;
+};
+
+} // namespace HEaaN
@@ -0,0 +1,138 @@
+////////////////////////////////////////////////////////////////////////////////
+//                                                                            //
+// Copyright (C) 2021-2023 Crypto Lab Inc.                                    //
+//                                                                            //
+// - This file is part of HEaaN homomorphic encryption library.               //
+// - HEaaN cannot be copied and/or distributed without the express permission //
+//  of Crypto Lab Inc.                                                        //
+//                                                                            //
+////////////////////////////////////////////////////////////////////////////////
+
+#pragma once
+
+#include <istream>
+#include <memory>
+#include <ostream>
+#include <string>
+#include <vector>
+
+#include "Context.hpp"
+#include "HEaaNExport.hpp"
+#include "Integers.hpp"
+#include "KeyPack.hpp"
+#include "Randomseeds.hpp"
+#include "SecretKey.hpp"
+
+namespace HEaaN {
+
+namespace detail {
+class NTT;
+} // namespace detail
+
+///
+///@brief An evaluation key whose uniform part is kept as a seed
+///@details A multiplication, conjugation or rotation key is a vector of pairs
+/// (b, a) with b = -as + e + (gadget), where a is uniformly random. A
+/// SeededEvaluationKey keeps b and a 32-byte seed in place of a, which is
+/// about half of what HEaaN::save(const EvaluationKey &, std::ostream &)
+/// writes. expand() regenerates a from the seed and writes the key in the
+/// format of HEaaN::save, and loadInto() does so straight into a KeyPack,
+/// e.g. on the server after an upload.
+///
+/// The seed is public, as for SeededCiphertext.
+///
+class HEAAN_API SeededEvaluationKey {
+    friend class SeededKeyCompressor;
+
+public:
+    explicit SeededEvaluationKey(const Context &context);
+
+    ///@brief Get the seed of the uniform part
+    const SeedType &getSeed() const { return seed_; }
+
+    ///@brief Get the size in bytes of the expanded key, i.e. of what expand()
+    /// writes
+    u64 getExpandedSize() const;
+
+    ///@brief Regenerate the uniform part and write the key in the format of
+    /// HEaaN::save(const EvaluationKey &, std::ostream &)
+    ///@details The output can be read by HEaaN::load(EvaluationKey &,
+    /// std::istream &) or by the KeyPack functions loading a key from a
+    /// stream.
+    ///@throws RuntimeException if the key is empty, i.e. neither compressed
+    /// nor loaded.
+    void expand(std::ostream &stream) const;
+
+    ///@brief Regenerate the uniform part and load the key into keypack as the
+    /// multiplication, conjugation or left rotation key it was made from
+    ///@throws RuntimeException if the key is empty.
+    void loadInto(KeyPack &keypack) const;
+
+    ///@brief Save the seed and b to a stream
+    ///@throws RuntimeException if the key is empty.
+    void save(std::ostream &stream) const;
+
+    ///@brief Save the seed and b to a file
+    ///@throws RuntimeException if the key is empty or the file cannot be
+    /// opened.
+    void save(const std::string &path) const;
+
+    ///@brief Load a key saved by save()
+    ///@details The layout of the key and the residues of b are checked
+    /// before the key is kept, as they may come from an upload; a failed load
+    /// leaves the key unchanged.
+    ///@throws RuntimeException if the stream does not hold a seeded
+    /// multiplication, conjugation or rotation key of the dimension and
+    /// primes of the context.
+    void load(std::istream &stream);
+
+    ///@brief Load a key saved by save() from a file
+    ///@throws RuntimeException if the file cannot be opened or does not hold
+    /// a seeded multiplication, conjugation or rotation key of the dimension
+    /// and primes of the context.
+    void load(const std::string &path);
+
+private:
+    Context context_;
+    SeedType seed_{};
+    ///@brief Serialized key up to the residues of the first a, i.e. the key
+    /// header, every b and the number of a
+    std::string prefix_;
+    ///@brief Serialized headers of every a
+    std::string a_headers_;
+};
+
+///
+///@brief Compressor of evaluation keys into SeededEvaluationKey with the
+/// secret key
+///@details The uniform part a of a key from KeyGenerator comes from the
+/// generator's own random stream, which also draws the secret error of the
+/// key, so it cannot be published as a seed. The compressor instead replaces
+/// a with a' drawn from a fresh public seed and corrects b to b + (a - a')s,
+/// which keeps the error of the key and gives an equally valid key.
+///
+/// Keys are processed in the serialized form of HEaaN::save, whose layout is
+/// checked before any residue is touched.
+///
+class HEAAN_API SeededKeyCompressor {
+public:
+    ///@brief Prepare the secret key in evaluation form over every prime of
+    /// context
+    ///@throws RuntimeException if sk does not reside on CPU.
+    explicit SeededKeyCompressor(const Context &context, const SecretKey &sk);
+
+    ///@brief Compress a multiplication, conjugation or rotation key
+    ///@param[in] key A key generated for the secret key of the compressor
+    ///@param[out] seeded
+    ///@throws RuntimeException if the serialized key does not have the
+    /// expected layout.
+    void compress(const EvaluationKey &key, SeededEvaluationKey &seeded) const;
+
+private:
+    Context context_;
+    std::vector<std::shared_ptr<const detail::NTT>> ntts_;
+    ///@brief s in evaluation form, one vector per prime
+    std::vector<std::vector<u64>> sx_;
+};
+
+} // namespace HEaaN
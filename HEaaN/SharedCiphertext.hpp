@@ -0,0 +1,80 @@
+////////////////////////////////////////////////////////////////////////////////
+//                                                                            //
+// Copyright (C) 2021-2023 Crypto Lab Inc.                                    //
+//                                                                            //
+// - This file is part of HEaaN homomorphic encryption library.               //
+// - HEaaN cannot be copied and/or distributed without the express permission //
+//  of Crypto Lab Inc.                                                        //
+//                                                                            //
+////////////////////////////////////////////////////////////////////////////////
+
+#pragma once
+
+#include <memory>
+
+#include "Ciphertext.hpp"
+#include "Context.hpp"
+#include "HEaaNExport.hpp"
+#include "Integers.hpp"
+
+namespace HEaaN {
+
+///
+///@brief A copy-on-write handle to a Ciphertext
+///@details Copying a Ciphertext copies all of its polynomial data. Copying a
+/// SharedCiphertext, or calling share(), only takes another reference to the
+/// same Ciphertext, so handles can be passed by value, stored in containers
+/// and captured in lambdas for the cost of a reference count. The data is
+/// copied when a handle which is not the only one is written through
+/// mutate(), and only then; clone() copies it explicitly.
+///
+/// Reading through handles to the same Ciphertext from several threads is
+/// safe, as is copying or destroying distinct handles concurrently. A single
+/// handle should not be written while other threads access it.
+///
+class HEAAN_API SharedCiphertext {
+public:
+    ///@brief Construct a handle to a new Ciphertext of context
+    ///@param[in] context
+    ///@param[in] is_extended
+    explicit SharedCiphertext(const Context &context,
+                              bool is_extended = false);
+
+    ///@brief Take over ctxt without copying its data
+    ///@param[in] ctxt
+    explicit SharedCiphertext(Ciphertext &&ctxt);
+
+    ///@brief Get another reference to the same Ciphertext
+    SharedCiphertext share() const { return *this; }
+
+    ///@brief Get a handle to a deep copy of the Ciphertext
+    SharedCiphertext clone() const;
+
+    ///@brief Get the Ciphertext for reading
+    const Ciphertext &get() const { return *ctxt_; }
+    const Ciphertext &operator*() const { return *ctxt_; }
+    const Ciphertext *operator->() const { return ctxt_.get(); }
+
+    ///@brief Get the Ciphertext for writing
+    ///@details The data is copied first if other handles refer to it, so that
+    /// writes never show through them. The reference stays valid until the
+    /// handle is assigned to or destroyed.
+    Ciphertext &mutate();
+
+    ///@brief Move the Ciphertext out of the handle
+    ///@details The data is moved if this is the only handle, and copied
+    /// otherwise. The handle is empty afterwards and may only be assigned to
+    /// or destroyed.
+    Ciphertext release();
+
+    ///@brief Whether no other handle refers to the Ciphertext
+    bool isUnique() const { return ctxt_.use_count() == 1; }
+
+    ///@brief Get the number of handles referring to the Ciphertext
+    u64 getUseCount() const { return static_cast<u64>(ctxt_.use_count()); }
+
+private:
+    std::shared_ptr<Ciphertext> ctxt_;
+};
+
+} // namespace HEaaN
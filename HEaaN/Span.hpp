@@ -0,0 +1,84 @@
+////////////////////////////////////////////////////////////////////////////////
+//                                                                            //
+// Copyright (C) 2021-2023 Crypto Lab Inc.                                    //
+//                                                                            //
+// - This file is part of HEaaN homomorphic encryption library.               //
+// - HEaaN cannot be copied and/or distributed without the express permission //
+//  of Crypto Lab Inc.                                                        //
+//                                                                            //
+////////////////////////////////////////////////////////////////////////////////
+
+#pragma once
+
+#include <array>
+#include <cstddef>
+#include <type_traits>
+#include <vector>
+
+#include "Integers.hpp"
+
+namespace HEaaN {
+
+///
+///@brief A non-owning view over a contiguous sequence of objects.
+///@details A minimal C++17 counterpart of std::span which is used by the
+/// functions operating on many objects at once. It can be constructed from a
+/// pointer and a size, a std::vector, a std::array or a built-in array without
+/// copying the elements.
+///
+template <class T> class Span {
+    template <class U>
+    using EnableIfConvertible =
+        std::enable_if_t<std::is_convertible_v<U (*)[], T (*)[]>, int>;
+
+public:
+    using element_type = T;
+    using value_type = std::remove_cv_t<T>;
+    using iterator = T *;
+
+    constexpr Span() noexcept = default;
+
+    constexpr Span(T *data, u64 size) noexcept : data_{data}, size_{size} {}
+
+    template <class U, EnableIfConvertible<U> = 0>
+    Span(std::vector<U> &vec) noexcept : data_{vec.data()}, size_{vec.size()} {}
+
+    template <class U, EnableIfConvertible<const U> = 0>
+    Span(const std::vector<U> &vec) noexcept
+        : data_{vec.data()}, size_{vec.size()} {}
+
+    template <class U, std::size_t N, EnableIfConvertible<U> = 0>
+    constexpr Span(std::array<U, N> &arr) noexcept
+        : data_{arr.data()}, size_{N} {}
+
+    template <class U, std::size_t N, EnableIfConvertible<const U> = 0>
+    constexpr Span(const std::array<U, N> &arr) noexcept
+        : data_{arr.data()}, size_{N} {}
+
+    template <std::size_t N>
+    constexpr Span(T (&arr)[N]) noexcept : data_{arr}, size_{N} {}
+
+    template <class U, EnableIfConvertible<U> = 0>
+    constexpr Span(const Span<U> &other) noexcept
+        : data_{other.data()}, size_{other.size()} {}
+
+    constexpr T *data() const noexcept { return data_; }
+    constexpr u64 size() const noexcept { return size_; }
+    constexpr bool empty() const noexcept { return size_ == 0; }
+
+    constexpr T &operator[](u64 idx) const { return data_[idx]; }
+
+    constexpr iterator begin() const noexcept { return data_; }
+    constexpr iterator end() const noexcept { return data_ + size_; }
+
+    ///@brief Get the view over count elements starting from offset
+    constexpr Span subspan(u64 offset, u64 count) const {
+        return Span{data_ + offset, count};
+    }
+
+private:
+    T *data_ = nullptr;
+    u64 size_ = 0;
+};
+
+} // namespace HEaaN
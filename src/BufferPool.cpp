@@ -0,0 +1,36 @@
+////////////////////////////////////////////////////////////////////////////////
+//                                                                            //
+// Copyright (C) 2021-2023 Crypto Lab Inc.                                    //
+//                                                                            //
+// - This file is part of HEaaN homomorphic encryption library.               //
+// - HEaaN cannot be copied and/or distributed without the express permission //
+//  of Crypto Lab Inc.                                                        //
+//                                                                            //
+////////////////////////////////////////////////////////////////////////////////
+
+#include "HEaaN/BufferPool.hpp"
+
+#include <algorithm>
+
+#include "ContextUtil.hpp"
+
+namespace HEaaN::detail {
+
+// The residues of a polynomial are contiguous across levels, so each
+// polynomial is a single range of (level + 1) * N words.
+void prefault(const Context &context, Ciphertext &ctxt) {
+    if (!isOnCPU(ctxt.getDevice()))
+        return;
+    const u64 length = (ctxt.getLevel() + 1) * getDegree(context);
+    for (u64 i = 0; i < ctxt.getSize(); ++i)
+        std::fill_n(ctxt.getPolyData(i, 0), length, 0);
+}
+
+void prefault(const Context &context, Plaintext &ptxt) {
+    if (!isOnCPU(ptxt.getDevice()))
+        return;
+    std::fill_n(ptxt.getMxData(0), (ptxt.getLevel() + 1) * getDegree(context),
+                0);
+}
+
+} // namespace HEaaN::detail
@@ -0,0 +1,118 @@
+////////////////////////////////////////////////////////////////////////////////
+//                                                                            //
+// Copyright (C) 2021-2023 Crypto Lab Inc.                                    //
+//                                                                            //
+// - This file is part of HEaaN homomorphic encryption library.               //
+// - HEaaN cannot be copied and/or distributed without the express permission //
+//  of Crypto Lab Inc.                                                        //
+//                                                                            //
+////////////////////////////////////////////////////////////////////////////////
+
+#pragma once
+
+#include <array>
+#include <cstdint>
+#include <random>
+
+#include "HEaaN/Integers.hpp"
+#include "HEaaN/Randomseeds.hpp"
+
+namespace HEaaN::detail {
+
+///@brief ChaCha20 keystream read as 64-bit words
+///@details The 256-bit key is a SeedType and the 64-bit stream identifier
+/// takes the place of the nonce, so that one seed expands into independent
+/// streams, e.g. one per prime.
+class ChaCha20 {
+public:
+    ChaCha20(const SeedType &key, u64 stream) {
+        state_[0] = 0x61707865;
+        state_[1] = 0x3320646e;
+        state_[2] = 0x79622d32;
+        state_[3] = 0x6b206574;
+        for (std::size_t i = 0; i < key.size(); ++i) {
+            state_[4 + 2 * i] = static_cast<std::uint32_t>(key[i]);
+            state_[5 + 2 * i] = static_cast<std::uint32_t>(key[i] >> 32);
+        }
+        state_[12] = 0;
+        state_[13] = 0;
+        state_[14] = static_cast<std::uint32_t>(stream);
+        state_[15] = static_cast<std::uint32_t>(stream >> 32);
+    }
+
+    u64 next() {
+        if (position_ == block_.size() / 2)
+            refill();
+        const u64 word = block_[2 * position_] |
+                         (static_cast<u64>(block_[2 * position_ + 1]) << 32);
+        ++position_;
+        return word;
+    }
+
+    ///@brief A uniform residue modulo prime, by rejection of masked words
+    u64 nextBelow(u64 prime) {
+        const u64 mask = ~U64ZERO >> __builtin_clzll(prime);
+        for (;;) {
+            const u64 word = next() & mask;
+            if (word < prime)
+                return word;
+        }
+    }
+
+    ///@brief A uniform real in [0, 1)
+    double nextUnit() {
+        return static_cast<double>(next() >> 11) * 0x1.0p-53;
+    }
+
+private:
+    static std::uint32_t rotl(std::uint32_t x, int n) {
+        return (x << n) | (x >> (32 - n));
+    }
+
+    static void quarterRound(std::array<std::uint32_t, 16> &x, int a, int b,
+                             int c, int d) {
+        x[a] += x[b];
+        x[d] = rotl(x[d] ^ x[a], 16);
+        x[c] += x[d];
+        x[b] = rotl(x[b] ^ x[c], 12);
+        x[a] += x[b];
+        x[d] = rotl(x[d] ^ x[a], 8);
+        x[c] += x[d];
+        x[b] = rotl(x[b] ^ x[c], 7);
+    }
+
+    void refill() {
+        std::array<std::uint32_t, 16> x = state_;
+        for (int round = 0; round < 10; ++round) {
+            quarterRound(x, 0, 4, 8, 12);
+            quarterRound(x, 1, 5, 9, 13);
+            quarterRound(x, 2, 6, 10, 14);
+            quarterRound(x, 3, 7, 11, 15);
+            quarterRound(x, 0, 5, 10, 15);
+            quarterRound(x, 1, 6, 11, 12);
+            quarterRound(x, 2, 7, 8, 13);
+            quarterRound(x, 3, 4, 9, 14);
+        }
+        for (std::size_t i = 0; i < x.size(); ++i)
+            block_[i] = x[i] + state_[i];
+        // 64-bit block counter in words 12 and 13
+        if (++state_[12] == 0)
+            ++state_[13];
+        position_ = 0;
+    }
+
+    std::array<std::uint32_t, 16> state_;
+    std::array<std::uint32_t, 16> block_{};
+    std::size_t position_ = block_.size() / 2;
+};
+
+///@brief Draw a fresh seed from std::random_device
+inline SeedType drawSeed() {
+    std::random_device device;
+    SeedType seed;
+    for (auto &word : seed)
+        word = (static_cast<u64>(device()) << 32) | device();
+    return seed;
+}
+
+} // namespace HEaaN::detail
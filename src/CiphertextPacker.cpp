@@ -0,0 +1,190 @@
+////////////////////////////////////////////////////////////////////////////////
+//                                                                            //
+// Copyright (C) 2021-2023 Crypto Lab Inc.                                    //
+//                                                                            //
+// - This file is part of HEaaN homomorphic encryption library.               //
+// - HEaaN cannot be copied and/or distributed without the express permission //
+//  of Crypto Lab Inc.                                                        //
+//                                                                            //
+////////////////////////////////////////////////////////////////////////////////
+
+#include "HEaaN/CiphertextPacker.hpp"
+
+#include <algorithm>
+#include <atomic>
+#include <limits>
+
+#include "ContextUtil.hpp"
+#include "HEaaN/Exception.hpp"
+#include "ParallelFor.hpp"
+#include "StreamUtil.hpp"
+
+namespace HEaaN {
+
+namespace {
+
+// "HEaaNPCT" in little endian
+constexpr u64 MAGIC = 0x5443504e61614548ULL;
+constexpr u64 VERSION = 1;
+constexpr u64 HEADER_SIZE = 7;
+
+// Pack count values below 2^bits into consecutive bits of out, least
+// significant first
+void packResidues(const u64 *in, u64 count, u64 bits, u64 *out) {
+    u64 acc = 0;
+    u64 filled = 0;
+    for (u64 i = 0; i < count; ++i) {
+        acc |= in[i] << filled;
+        filled += bits;
+        if (filled >= 64) {
+            *out++ = acc;
+            filled -= 64;
+            acc = filled == 0 ? 0 : in[i] >> (bits - filled);
+        }
+    }
+    if (filled != 0)
+        *out = acc;
+}
+
+// Inverse of packResidues. Returns false if a value is not below prime.
+bool unpackResidues(const u64 *in, u64 count, u64 bits, u64 prime,
+                    u64 *out) {
+    const u64 mask = (U64ONE << bits) - 1;
+    u64 acc = 0;
+    u64 avail = 0;
+    bool valid = true;
+    for (u64 i = 0; i < count; ++i) {
+        u64 value;
+        if (avail >= bits) {
+            value = acc & mask;
+            acc >>= bits;
+            avail -= bits;
+        } else {
+            const u64 word = *in++;
+            value = (acc | (word << avail)) & mask;
+            acc = word >> (bits - avail);
+            avail = 64 - (bits - avail);
+        }
+        valid &= value < prime;
+        out[i] = value;
+    }
+    return valid;
+}
+
+} // namespace
+
+CiphertextPacker::CiphertextPacker(const Context &context)
+    : context_{context}, degree_{detail::getDegree(context)},
+      primes_{getPrimeList(context)}, max_level_{detail::getMaxLevel(context)} {
+    bits_.reserve(primes_.size());
+    for (const u64 prime : primes_)
+        bits_.push_back(static_cast<u64>(64 - __builtin_clzll(prime - 1)));
+}
+
+u64 CiphertextPacker::getNumWords(u64 level) const {
+    return (degree_ * bits_[level] + 63) / 64;
+}
+
+u64 CiphertextPacker::getPackedSize(const Ciphertext &ctxt) const {
+    u64 words = 0;
+    for (u64 l = 0; l <= ctxt.getLevel(); ++l)
+        words += getNumWords(l);
+    return (HEADER_SIZE + ctxt.getSize() * words) * sizeof(u64);
+}
+
+void CiphertextPacker::save(const Ciphertext &ctxt,
+                            std::ostream &stream) const {
+    if (!detail::isOnCPU(ctxt.getDevice()))
+        throw RuntimeException("[CiphertextPacker::save] The ciphertext "
+                               "should reside on CPU");
+    if (ctxt.isModUp())
+        throw RuntimeException("[CiphertextPacker::save] Mod-up ciphertexts "
+                               "cannot be packed");
+    if (ctxt.getSize() > detail::MAX_CIPHERTEXT_SIZE)
+        throw RuntimeException("[CiphertextPacker::save] Ciphertexts of more "
+                               "than three polynomials cannot be packed");
+
+    const u64 level = ctxt.getLevel();
+    std::vector<u64> offsets{0};
+    for (u64 l = 0; l <= level; ++l)
+        offsets.push_back(offsets.back() + getNumWords(l));
+    const u64 poly_words = offsets.back();
+
+    std::vector<u64> packed(ctxt.getSize() * poly_words);
+    parallelFor(ctxt.getSize() * (level + 1), [&](u64 index) {
+        const u64 i = index / (level + 1);
+        const u64 l = index % (level + 1);
+        packResidues(ctxt.getPolyData(i, l), degree_, bits_[l],
+                     packed.data() + i * poly_words + offsets[l]);
+    });
+
+    const u64 header[HEADER_SIZE] = {
+        MAGIC,
+        VERSION,
+        degree_,
+        ctxt.getSize(),
+        level,
+        static_cast<u64>(static_cast<i64>(ctxt.getRescaleCounter())),
+        ctxt.getLogSlots()};
+    detail::writeWords(stream, header, HEADER_SIZE);
+    detail::writeWords(stream, packed.data(), packed.size());
+}
+
+void CiphertextPacker::load(std::istream &stream, Ciphertext &ctxt) const {
+    if (!detail::isOnCPU(ctxt.getDevice()))
+        throw RuntimeException("[CiphertextPacker::load] The ciphertext "
+                               "should reside on CPU");
+
+    u64 header[HEADER_SIZE];
+    detail::readWords(stream, header, HEADER_SIZE, "CiphertextPacker::load");
+    if (header[0] != MAGIC || header[1] != VERSION)
+        throw RuntimeException("[CiphertextPacker::load] The stream does not "
+                               "hold a packed ciphertext");
+    const u64 size = header[3];
+    const u64 level = header[4];
+    if (header[2] != degree_ || size < 2 ||
+        size > detail::MAX_CIPHERTEXT_SIZE || level > max_level_ ||
+        header[5] > static_cast<u64>(std::numeric_limits<int>::max()) ||
+        header[6] > getLogFullSlots(context_))
+        throw RuntimeException("[CiphertextPacker::load] The ciphertext does "
+                               "not fit the context");
+
+    std::vector<u64> offsets{0};
+    for (u64 l = 0; l <= level; ++l)
+        offsets.push_back(offsets.back() + getNumWords(l));
+    const u64 poly_words = offsets.back();
+    std::vector<u64> packed(size * poly_words);
+    detail::readWords(stream, packed.data(), packed.size(),
+                      "CiphertextPacker::load");
+
+    // Unpack and validate everything before touching ctxt, so that a failed
+    // load leaves it as it was.
+    const u64 num_arrays = size * (level + 1);
+    std::vector<u64> residues(num_arrays * degree_);
+    std::atomic<bool> valid{true};
+    parallelFor(num_arrays, [&](u64 index) {
+        const u64 i = index / (level + 1);
+        const u64 l = index % (level + 1);
+        if (!unpackResidues(packed.data() + i * poly_words + offsets[l],
+                            degree_, bits_[l], primes_[l],
+                            residues.data() + index * degree_))
+            valid = false;
+    });
+    if (!valid)
+        throw RuntimeException("[CiphertextPacker::load] The ciphertext does "
+                               "not fit the primes of the context");
+
+    // Raising the level and size of ctxt allocates what it lacks.
+    ctxt.setSize(size);
+    ctxt.setLevel(level);
+    ctxt.setRescaleCounter(static_cast<int>(header[5]));
+    ctxt.setLogSlots(header[6]);
+    parallelFor(num_arrays, [&](u64 index) {
+        const u64 i = index / (level + 1);
+        const u64 l = index % (level + 1);
+        std::copy_n(residues.data() + index * degree_, degree_,
+                    ctxt.getPolyData(i, l));
+    });
+}
+
+} // namespace HEaaN
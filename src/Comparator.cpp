@@ -0,0 +1,185 @@
+////////////////////////////////////////////////////////////////////////////////
+//                                                                            //
+// Copyright (C) 2021-2023 Crypto Lab Inc.                                    //
+//                                                                            //
+// - This file is part of HEaaN homomorphic encryption library.               //
+// - HEaaN cannot be copied and/or distributed without the express permission //
+//  of Crypto Lab Inc.                                                        //
+//                                                                            //
+////////////////////////////////////////////////////////////////////////////////
+
+#include "HEaaN/Comparator.hpp"
+
+#include <cmath>
+
+#include "HEaaN/Ciphertext.hpp"
+#include "HEaaN/Exception.hpp"
+
+namespace HEaaN {
+
+namespace {
+
+// f_3(x) = (35x - 35x^3 + 21x^5 - 5x^7) / 2^4
+const std::vector<Real> F_COEFFS{
+    0, 35.0 / 16, 0, -35.0 / 16, 0, 21.0 / 16, 0, -5.0 / 16};
+// g_3(x) = (4589x - 16577x^3 + 25614x^5 - 12860x^7) / 2^10
+const std::vector<Real> G_COEFFS{
+    0, 4589.0 / 1024, 0, -16577.0 / 1024, 0, 25614.0 / 1024, 0,
+    -12860.0 / 1024};
+
+constexpr u64 MAX_LOG_PRECISION = 30;
+constexpr u64 MAX_ITERATIONS = 64;
+constexpr u64 NUM_SAMPLES = 2048;
+
+Real evaluateReal(const std::vector<Real> &coeffs, Real x) {
+    Real y = 0;
+    for (u64 i = coeffs.size(); i-- > 0;)
+        y = y * x + coeffs[i];
+    return y;
+}
+
+// Whether num_g iterations of g followed by num_f iterations of f bring
+// every x in [2^-log_gap, 1] within 2^-log_error of 1. As both polynomials
+// are odd, negative inputs follow by symmetry.
+bool meetsConfig(u64 num_g, u64 num_f, const ComparisonConfig &config) {
+    const Real gap = std::ldexp(REAL_ONE, -static_cast<int>(config.log_gap));
+    const Real error =
+        std::ldexp(REAL_ONE, -static_cast<int>(config.log_error));
+    for (u64 s = 0; s <= NUM_SAMPLES; ++s) {
+        // Log-spaced samples from the gap up to 1
+        Real x = std::pow(gap, REAL_ONE - static_cast<Real>(s) / NUM_SAMPLES);
+        for (u64 i = 0; i < num_g; ++i)
+            x = evaluateReal(G_COEFFS, x);
+        for (u64 i = 0; i < num_f; ++i)
+            x = evaluateReal(F_COEFFS, x);
+        if (std::abs(REAL_ONE - x) > error)
+            return false;
+    }
+    return true;
+}
+
+} // namespace
+
+Comparator::Comparator(const HomEvaluator &eval, const Bootstrapper &btp,
+                       const ComparisonConfig &config)
+    : eval_{eval}, btp_{btp}, poly_eval_{eval}, num_g_iters_{0},
+      num_f_iters_{0} {
+    if (config.log_gap == 0 || config.log_gap > MAX_LOG_PRECISION ||
+        config.log_error == 0 || config.log_error > MAX_LOG_PRECISION)
+        throw RuntimeException("[Comparator] log_gap and log_error should be "
+                               "between 1 and 30");
+    const u64 stage_depth = PolynomialEvaluator::getDepth(F_COEFFS.size() - 1);
+    // relu, max and min spend one level after the last iteration.
+    if (btp_.getLevelAfterFullSlotBootstrap() <
+        stage_depth + btp_.getMinLevelForBootstrap() + 1)
+        throw RuntimeException("[Comparator] The level after bootstrap is "
+                               "too low for the comparison polynomials");
+
+    // Fewest iterations in total; among those, the most iterations of f,
+    // which converges faster once the input is away from zero.
+    for (u64 total = 1; total <= MAX_ITERATIONS && num_f_iters_ == 0;
+         ++total) {
+        for (u64 num_f = total; num_f >= 1; --num_f) {
+            if (meetsConfig(total - num_f, num_f, config)) {
+                num_g_iters_ = total - num_f;
+                num_f_iters_ = num_f;
+                break;
+            }
+        }
+    }
+    if (num_f_iters_ == 0)
+        throw RuntimeException("[Comparator] Could not meet the precision");
+}
+
+u64 Comparator::getDepth() const {
+    return (num_g_iters_ + num_f_iters_) *
+           PolynomialEvaluator::getDepth(F_COEFFS.size() - 1);
+}
+
+void Comparator::sign(const Ciphertext &ctxt, Ciphertext &ctxt_out) const {
+    signAffine(ctxt, REAL_ONE, REAL_ZERO, 0, ctxt_out);
+}
+
+void Comparator::compare(const Ciphertext &ctxt1, const Ciphertext &ctxt2,
+                         Ciphertext &ctxt_out) const {
+    Ciphertext diff(eval_.getContext());
+    eval_.sub(ctxt1, ctxt2, diff);
+    signAffine(diff, 0.5, 0.5, 0, ctxt_out);
+}
+
+void Comparator::max(const Ciphertext &ctxt1, const Ciphertext &ctxt2,
+                     Ciphertext &ctxt_out) const {
+    Ciphertext diff(eval_.getContext());
+    eval_.sub(ctxt1, ctxt2, diff);
+    relu(diff, diff);
+    eval_.add(ctxt2, diff, ctxt_out);
+}
+
+void Comparator::min(const Ciphertext &ctxt1, const Ciphertext &ctxt2,
+                     Ciphertext &ctxt_out) const {
+    Ciphertext diff(eval_.getContext());
+    eval_.sub(ctxt1, ctxt2, diff);
+    relu(diff, diff);
+    eval_.sub(ctxt1, diff, ctxt_out);
+}
+
+void Comparator::relu(const Ciphertext &ctxt, Ciphertext &ctxt_out) const {
+    // The multiplication by x takes the level of x down by one, so x is
+    // bootstrapped first if that would leave the result below the minimum
+    // level for bootstrap.
+    const u64 min_boot_level = btp_.getMinLevelForBootstrap();
+    Ciphertext input(eval_.getContext());
+    if (ctxt.getLevel() <= min_boot_level) {
+        if (ctxt.getLevel() < min_boot_level)
+            throw RuntimeException("[Comparator] The level of the "
+                                   "ciphertext is too low to bootstrap");
+        if (ctxt.getRescaleCounter() != 0)
+            throw RuntimeException("[Comparator] Rescale counter of the "
+                                   "ciphertext should be zero");
+        btp_.bootstrap(ctxt, input);
+    } else {
+        input = ctxt;
+    }
+
+    Ciphertext step(eval_.getContext());
+    signAffine(input, 0.5, 0.5, 1, step);
+    eval_.mult(input, step, ctxt_out);
+}
+
+void Comparator::signAffine(const Ciphertext &ctxt, Real scale, Real shift,
+                            u64 extra_depth, Ciphertext &ctxt_out) const {
+    if (ctxt.getRescaleCounter() != 0)
+        throw RuntimeException("[Comparator] Rescale counter of the "
+                               "ciphertext should be zero");
+
+    const u64 num_iters = num_g_iters_ + num_f_iters_;
+    const u64 stage_depth = PolynomialEvaluator::getDepth(F_COEFFS.size() - 1);
+    const u64 min_boot_level = btp_.getMinLevelForBootstrap();
+
+    std::vector<Real> last_coeffs(F_COEFFS);
+    for (auto &coeff : last_coeffs)
+        coeff *= scale;
+    last_coeffs[0] += shift;
+
+    Ciphertext result(ctxt);
+    for (u64 i = 0; i < num_iters; ++i) {
+        const u64 depth =
+            i + 1 < num_iters ? stage_depth : stage_depth + extra_depth;
+        if (result.getLevel() < depth + min_boot_level) {
+            if (result.getLevel() < min_boot_level)
+                throw RuntimeException("[Comparator] The level of the "
+                                       "ciphertext is too low to bootstrap");
+            Ciphertext refreshed(eval_.getContext());
+            btp_.bootstrap(result, refreshed);
+            result = std::move(refreshed);
+        }
+        const auto &coeffs = i < num_g_iters_         ? G_COEFFS
+                             : i + 1 < num_iters ? F_COEFFS
+                                                 : last_coeffs;
+        poly_eval_.evaluate(result, coeffs, PolynomialBasis::MONOMIAL,
+                            result);
+    }
+    ctxt_out = std::move(result);
+}
+
+} // namespace HEaaN
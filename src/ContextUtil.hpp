@@ -0,0 +1,40 @@
+////////////////////////////////////////////////////////////////////////////////
+//                                                                            //
+// Copyright (C) 2021-2023 Crypto Lab Inc.                                    //
+//                                                                            //
+// - This file is part of HEaaN homomorphic encryption library.               //
+// - HEaaN cannot be copied and/or distributed without the express permission //
+//  of Crypto Lab Inc.                                                        //
+//                                                                            //
+////////////////////////////////////////////////////////////////////////////////
+
+#pragma once
+
+#include "HEaaN/Context.hpp"
+#include "HEaaN/Integers.hpp"
+#include "HEaaN/device/Device.hpp"
+
+namespace HEaaN::detail {
+
+///@brief Maximal number of polynomials of a ciphertext: two, or three between
+/// tensor and relinearize
+constexpr u64 MAX_CIPHERTEXT_SIZE = 3;
+
+///@brief Get the dimension N, the number of words per residue array
+inline u64 getDegree(const Context &context) {
+    return U64ONE << (getLogFullSlots(context) + 1);
+}
+
+///@brief Get the maximal level of a ciphertext, one below the number of
+/// default scale factors
+///@details getPrimeList() also holds the special primes of key switching, so
+/// its size does not bound the level.
+inline u64 getMaxLevel(const Context &context) {
+    return getDefaultScaleFactorList(context).size() - 1;
+}
+
+inline bool isOnCPU(const Device &device) {
+    return device.type() == DeviceType::CPU;
+}
+
+} // namespace HEaaN::detail
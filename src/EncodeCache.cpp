@@ -0,0 +1,162 @@
+////////////////////////////////////////////////////////////////////////////////
+//                                                                            //
+// Copyright (C) 2021-2023 Crypto Lab Inc.                                    //
+//                                                                            //
+// - This file is part of HEaaN homomorphic encryption library.               //
+// - HEaaN cannot be copied and/or distributed without the express permission //
+//  of Crypto Lab Inc.                                                        //
+//                                                                            //
+////////////////////////////////////////////////////////////////////////////////
+
+#include "HEaaN/EncodeCache.hpp"
+
+#include <algorithm>
+#include <cstring>
+#include <utility>
+
+#include "ContextUtil.hpp"
+#include "HEaaN/Exception.hpp"
+
+namespace HEaaN {
+
+namespace {
+
+u64 mix(u64 x) {
+    x ^= x >> 30;
+    x *= 0xbf58476d1ce4e5b9ULL;
+    x ^= x >> 27;
+    x *= 0x94d049bb133111ebULL;
+    x ^= x >> 31;
+    return x;
+}
+
+// Hash of the bit patterns of the slot values
+u64 hashSlots(const Message &msg) {
+    u64 hash = msg.getSize();
+    for (const Complex &value : msg) {
+        u64 bits[2];
+        const Real parts[2] = {value.real(), value.imag()};
+        std::memcpy(bits, parts, sizeof(bits));
+        hash = mix(hash ^ bits[0]) + bits[1];
+    }
+    return mix(hash);
+}
+
+bool equalSlots(const Message &msg1, const Message &msg2) {
+    return msg1.getSize() == msg2.getSize() &&
+           std::equal(msg1.begin(), msg1.end(), msg2.begin());
+}
+
+u64 estimateBytes(const Context &context, const Plaintext &ptxt,
+                  const Message &msg) {
+    const u64 degree = detail::getDegree(context);
+    return (ptxt.getLevel() + 1) * degree * sizeof(u64) +
+           msg.getSize() * sizeof(Complex);
+}
+
+} // namespace
+
+std::size_t EncodeCache::KeyHash::operator()(const Key &key) const {
+    const auto &[hash, log_slots, level, r_counter] = key;
+    return static_cast<std::size_t>(
+        mix(hash ^ (log_slots << 48) ^ (level << 8) ^
+            static_cast<u64>(static_cast<unsigned>(r_counter))));
+}
+
+EncodeCache::EncodeCache(const Context &context, u64 memory_budget)
+    : context_{context}, encoder_{context}, memory_budget_{memory_budget},
+      memory_usage_{0}, num_hits_{0}, num_misses_{0} {}
+
+std::shared_ptr<const Plaintext>
+EncodeCache::encode(const Message &msg, u64 level, int r_counter) {
+    if (!detail::isOnCPU(msg.getDevice()))
+        throw RuntimeException("[EncodeCache::encode] The message should "
+                               "reside on CPU");
+
+    const Key key{hashSlots(msg), msg.getLogSlots(), level, r_counter};
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        auto it = cache_.find(key);
+        if (it != cache_.end() && equalSlots(it->second.msg, msg)) {
+            lru_.splice(lru_.begin(), lru_, it->second.lru_pos);
+            ++num_hits_;
+            return it->second.ptxt;
+        }
+        ++num_misses_;
+    }
+
+    // Encode without holding the lock so that other messages are served
+    // meanwhile. A message encoded by two threads at once is cached once.
+    auto ptxt = std::make_shared<const Plaintext>(
+        encoder_.encode(msg, level, r_counter));
+    const u64 bytes = estimateBytes(context_, *ptxt, msg);
+
+    std::lock_guard<std::mutex> lock(mutex_);
+    auto it = cache_.find(key);
+    if (it != cache_.end()) {
+        if (equalSlots(it->second.msg, msg))
+            return it->second.ptxt;
+        // A different message with the same hash is replaced.
+        memory_usage_ -= it->second.bytes;
+        lru_.erase(it->second.lru_pos);
+        cache_.erase(it);
+    }
+    lru_.push_front(key);
+    cache_.emplace(key, Entry{msg, ptxt, bytes, lru_.begin()});
+    memory_usage_ += bytes;
+    evictToBudget();
+    return ptxt;
+}
+
+u64 EncodeCache::getMemoryBudget() const {
+    std::lock_guard<std::mutex> lock(mutex_);
+    return memory_budget_;
+}
+
+void EncodeCache::setMemoryBudget(u64 memory_budget) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    memory_budget_ = memory_budget;
+    evictToBudget();
+}
+
+u64 EncodeCache::getMemoryUsage() const {
+    std::lock_guard<std::mutex> lock(mutex_);
+    return memory_usage_;
+}
+
+u64 EncodeCache::getNumCachedPlaintexts() const {
+    std::lock_guard<std::mutex> lock(mutex_);
+    return cache_.size();
+}
+
+u64 EncodeCache::getNumHits() const {
+    std::lock_guard<std::mutex> lock(mutex_);
+    return num_hits_;
+}
+
+u64 EncodeCache::getNumMisses() const {
+    std::lock_guard<std::mutex> lock(mutex_);
+    return num_misses_;
+}
+
+void EncodeCache::clear() {
+    std::lock_guard<std::mutex> lock(mutex_);
+    cache_.clear();
+    lru_.clear();
+    memory_usage_ = 0;
+    num_hits_ = 0;
+    num_misses_ = 0;
+}
+
+void EncodeCache::evictToBudget() {
+    if (memory_budget_ == 0)
+        return;
+    while (memory_usage_ > memory_budget_ && !lru_.empty()) {
+        auto it = cache_.find(lru_.back());
+        memory_usage_ -= it->second.bytes;
+        cache_.erase(it);
+        lru_.pop_back();
+    }
+}
+
+} // namespace HEaaN
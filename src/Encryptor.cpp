@@ -0,0 +1,95 @@
+////////////////////////////////////////////////////////////////////////////////
+//                                                                            //
+// Copyright (C) 2021-2023 Crypto Lab Inc.                                    //
+//                                                                            //
+// - This file is part of HEaaN homomorphic encryption library.               //
+// - HEaaN cannot be copied and/or distributed without the express permission //
+//  of Crypto Lab Inc.                                                        //
+//                                                                            //
+////////////////////////////////////////////////////////////////////////////////
+
+#include "HEaaN/Encryptor.hpp"
+
+#include <memory>
+#include <mutex>
+
+#include "HEaaN/Ciphertext.hpp"
+#include "HEaaN/Exception.hpp"
+#include "HEaaN/KeyPack.hpp"
+#include "HEaaN/Message.hpp"
+#include "HEaaN/SecretKey.hpp"
+#include "ParallelFor.hpp"
+
+namespace HEaaN {
+
+namespace {
+
+// Encrypt msgs[i] on worker threads into the ciphertext which output(i)
+// points to, and pass it to sink if there is one. The pointer is dropped once
+// the ciphertext has been passed on.
+template <class Key, class Output>
+void encryptEach(const Encryptor &encryptor, Span<const Message> msgs,
+                 const Key &key, u64 level, int r_counter,
+                 const Encryptor::BatchSink &sink, Output &&output) {
+    std::mutex sink_mutex;
+    parallelFor(msgs.size(), [&](u64 i) {
+        const auto ctxt = output(i);
+        encryptor.encrypt(msgs[i], key, *ctxt, level, r_counter);
+        if (sink) {
+            std::lock_guard<std::mutex> lock(sink_mutex);
+            sink(i, *ctxt);
+        }
+    });
+}
+
+template <class Key>
+void encryptInto(const Encryptor &encryptor, Span<const Message> msgs,
+                 const Key &key, Span<Ciphertext> ctxts, u64 level,
+                 int r_counter, const Encryptor::BatchSink &sink) {
+    if (msgs.size() != ctxts.size())
+        throw RuntimeException("[Encryptor::encryptBatch] The numbers of "
+                               "messages and ciphertexts are different");
+    encryptEach(encryptor, msgs, key, level, r_counter, sink,
+                [&](u64 i) { return &ctxts[i]; });
+}
+
+template <class Key>
+void encryptToSink(const Context &context, const Encryptor &encryptor,
+                   Span<const Message> msgs, const Key &key,
+                   const Encryptor::BatchSink &sink, u64 level,
+                   int r_counter) {
+    if (!sink)
+        throw RuntimeException("[Encryptor::encryptBatch] The sink is empty");
+    // A new ciphertext per message, which sink may move out, and which is
+    // freed right after the sink otherwise.
+    encryptEach(encryptor, msgs, key, level, r_counter, sink,
+                [&](u64) { return std::make_unique<Ciphertext>(context); });
+}
+
+} // namespace
+
+void Encryptor::encryptBatch(Span<const Message> msgs, const KeyPack &keypack,
+                             Span<Ciphertext> ctxts, u64 level, int r_counter,
+                             const BatchSink &sink) const {
+    encryptInto(*this, msgs, keypack, ctxts, level, r_counter, sink);
+}
+
+void Encryptor::encryptBatch(Span<const Message> msgs, const SecretKey &sk,
+                             Span<Ciphertext> ctxts, u64 level, int r_counter,
+                             const BatchSink &sink) const {
+    encryptInto(*this, msgs, sk, ctxts, level, r_counter, sink);
+}
+
+void Encryptor::encryptBatch(Span<const Message> msgs, const KeyPack &keypack,
+                             const BatchSink &sink, u64 level,
+                             int r_counter) const {
+    encryptToSink(context_, *this, msgs, keypack, sink, level, r_counter);
+}
+
+void Encryptor::encryptBatch(Span<const Message> msgs, const SecretKey &sk,
+                             const BatchSink &sink, u64 level,
+                             int r_counter) const {
+    encryptToSink(context_, *this, msgs, sk, sink, level, r_counter);
+}
+
+} // namespace HEaaN
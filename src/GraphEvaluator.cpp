@@ -0,0 +1,542 @@
+////////////////////////////////////////////////////////////////////////////////
+//                                                                            //
+// Copyright (C) 2021-2023 Crypto Lab Inc.                                    //
+//                                                                            //
+// - This file is part of HEaaN homomorphic encryption library.               //
+// - HEaaN cannot be copied and/or distributed without the express permission //
+//  of Crypto Lab Inc.                                                        //
+//                                                                            //
+////////////////////////////////////////////////////////////////////////////////
+
+#include "HEaaN/GraphEvaluator.hpp"
+
+#include <algorithm>
+#include <cmath>
+#include <limits>
+#include <memory>
+#include <string>
+#include <utility>
+
+#include "HEaaN/Ciphertext.hpp"
+#include "HEaaN/Exception.hpp"
+#include "HEaaN/Plaintext.hpp"
+#include "InnerProduct.hpp"
+#include "ParallelFor.hpp"
+
+namespace HEaaN {
+
+namespace {
+
+constexpr u64 NO_NODE = std::numeric_limits<u64>::max();
+
+// HomEvaluator::mult multiplies by such constants with multInteger, without
+// consuming a level.
+bool isGaussianInteger(const Complex &cnst) {
+    constexpr Real tolerance = 1e-8;
+    return std::abs(cnst.real() - std::round(cnst.real())) <= tolerance &&
+           std::abs(cnst.imag() - std::round(cnst.imag())) <= tolerance;
+}
+
+// A sum Σ ±p_i + Σ ±o_j of products p_i whose intermediate results are not
+// needed elsewhere, and other nodes o_j
+struct Fusion {
+    std::vector<std::pair<u64, bool>> products;
+    std::vector<std::pair<u64, bool>> others;
+};
+
+} // namespace
+
+GraphEvaluator::GraphEvaluator(const HomEvaluator &eval) : eval_{eval} {}
+
+GraphEvaluator::NodeId GraphEvaluator::input(const Ciphertext &ctxt) {
+    if (ctxt.getRescaleCounter() != 0)
+        throw RuntimeException("[GraphEvaluator::input] Rescale counter of "
+                               "the ciphertext should be zero");
+    return record("GraphEvaluator::input",
+                  Node{OpType::INPUT, NO_NODE, NO_NODE, 0, COMPLEX_ZERO, &ctxt,
+                       nullptr, ctxt.getLevel()});
+}
+
+GraphEvaluator::NodeId GraphEvaluator::add(NodeId op1, NodeId op2) {
+    return record("GraphEvaluator::add",
+                  Node{OpType::ADD, std::min(op1, op2), std::max(op1, op2), 0,
+                       COMPLEX_ZERO, nullptr, nullptr, 0});
+}
+
+GraphEvaluator::NodeId GraphEvaluator::add(NodeId op,
+                                           const Complex &cnst_complex) {
+    return record("GraphEvaluator::add",
+                  Node{OpType::ADD_CONST, op, NO_NODE, 0, cnst_complex,
+                       nullptr, nullptr, 0});
+}
+
+GraphEvaluator::NodeId GraphEvaluator::sub(NodeId op1, NodeId op2) {
+    return record("GraphEvaluator::sub",
+                  Node{OpType::SUB, op1, op2, 0, COMPLEX_ZERO, nullptr,
+                       nullptr, 0});
+}
+
+GraphEvaluator::NodeId GraphEvaluator::negate(NodeId op) {
+    return record("GraphEvaluator::negate",
+                  Node{OpType::NEGATE, op, NO_NODE, 0, COMPLEX_ZERO, nullptr,
+                       nullptr, 0});
+}
+
+GraphEvaluator::NodeId GraphEvaluator::mult(NodeId op1, NodeId op2) {
+    if (op1 == op2)
+        return square(op1);
+    return record("GraphEvaluator::mult",
+                  Node{OpType::MULT, std::min(op1, op2), std::max(op1, op2), 0,
+                       COMPLEX_ZERO, nullptr, nullptr, 0});
+}
+
+GraphEvaluator::NodeId GraphEvaluator::mult(NodeId op, const Plaintext &ptxt) {
+    return record("GraphEvaluator::mult",
+                  Node{OpType::MULT_PTXT, op, NO_NODE, 0, COMPLEX_ZERO,
+                       nullptr, &ptxt, 0});
+}
+
+GraphEvaluator::NodeId GraphEvaluator::mult(NodeId op,
+                                            const Complex &cnst_complex) {
+    return record("GraphEvaluator::mult",
+                  Node{OpType::MULT_CONST, op, NO_NODE, 0, cnst_complex,
+                       nullptr, nullptr, 0});
+}
+
+GraphEvaluator::NodeId GraphEvaluator::square(NodeId op) {
+    return record("GraphEvaluator::square",
+                  Node{OpType::SQUARE, op, NO_NODE, 0, COMPLEX_ZERO, nullptr,
+                       nullptr, 0});
+}
+
+GraphEvaluator::NodeId GraphEvaluator::leftRotate(NodeId op, u64 rot) {
+    return record("GraphEvaluator::leftRotate",
+                  Node{OpType::LEFT_ROTATE, op, NO_NODE, rot, COMPLEX_ZERO,
+                       nullptr, nullptr, 0});
+}
+
+GraphEvaluator::NodeId GraphEvaluator::levelDown(NodeId op,
+                                                 u64 target_level) {
+    checkNode("GraphEvaluator::levelDown", op);
+    if (target_level > nodes_[op].level)
+        throw RuntimeException("[GraphEvaluator::levelDown] The target level "
+                               "is above the level of the node");
+    // Bringing a node to its own level is a no-op, and a chain of levelDown
+    // calls is a single one from the original node.
+    if (target_level == nodes_[op].level)
+        return op;
+    if (nodes_[op].op == OpType::LEVEL_DOWN)
+        op = nodes_[op].lhs;
+    return record("GraphEvaluator::levelDown",
+                  Node{OpType::LEVEL_DOWN, op, NO_NODE, target_level,
+                       COMPLEX_ZERO, nullptr, nullptr, 0});
+}
+
+u64 GraphEvaluator::getLevel(NodeId node) const {
+    checkNode("GraphEvaluator::getLevel", node);
+    return nodes_[node].level;
+}
+
+void GraphEvaluator::clear() {
+    nodes_.clear();
+    index_.clear();
+}
+
+void GraphEvaluator::checkNode(const char *func, NodeId node) const {
+    if (node >= nodes_.size())
+        throw RuntimeException(std::string{"["} + func +
+                               "] The node does not exist");
+}
+
+GraphEvaluator::NodeId GraphEvaluator::record(const char *func, Node node) {
+    if (node.lhs != NO_NODE)
+        checkNode(func, node.lhs);
+    if (node.rhs != NO_NODE)
+        checkNode(func, node.rhs);
+
+    const auto level = [&](NodeId id) { return nodes_[id].level; };
+    const auto consume = [&](u64 operand_level) {
+        if (operand_level == 0)
+            throw RuntimeException(std::string{"["} + func +
+                                   "] The level of the operands should be "
+                                   "positive");
+        return operand_level - 1;
+    };
+    switch (node.op) {
+    case OpType::INPUT:
+        break;
+    case OpType::LEVEL_DOWN:
+        node.level = node.param;
+        break;
+    case OpType::ADD:
+    case OpType::SUB:
+        node.level = std::min(level(node.lhs), level(node.rhs));
+        break;
+    case OpType::ADD_CONST:
+    case OpType::NEGATE:
+    case OpType::LEFT_ROTATE:
+        node.level = level(node.lhs);
+        break;
+    case OpType::MULT:
+        node.level = consume(std::min(level(node.lhs), level(node.rhs)));
+        break;
+    case OpType::MULT_PTXT:
+        node.level =
+            consume(std::min(level(node.lhs), node.ptxt->getLevel()));
+        break;
+    case OpType::MULT_CONST:
+        node.level = isGaussianInteger(node.cnst) ? level(node.lhs)
+                                                  : consume(level(node.lhs));
+        break;
+    case OpType::SQUARE:
+        node.level = consume(level(node.lhs));
+        break;
+    }
+
+    const void *ref = node.ctxt != nullptr
+                          ? static_cast<const void *>(node.ctxt)
+                          : static_cast<const void *>(node.ptxt);
+    const Key key{node.op,          node.lhs,          node.rhs, node.param,
+                  node.cnst.real(), node.cnst.imag(), ref};
+    if (auto it = index_.find(key); it != index_.end())
+        return it->second;
+    nodes_.push_back(node);
+    index_.emplace(key, nodes_.size() - 1);
+    return nodes_.size() - 1;
+}
+
+void GraphEvaluator::execute(const std::vector<NodeId> &outputs,
+                             std::vector<Ciphertext> &ctxts_out) const {
+    const Context &context = eval_.getContext();
+    const u64 num_nodes = nodes_.size();
+    for (NodeId id : outputs)
+        checkNode("GraphEvaluator::execute", id);
+
+    const auto operands = [&](NodeId id) {
+        std::vector<NodeId> ops;
+        if (nodes_[id].lhs != NO_NODE)
+            ops.push_back(nodes_[id].lhs);
+        if (nodes_[id].rhs != NO_NODE)
+            ops.push_back(nodes_[id].rhs);
+        return ops;
+    };
+
+    // Nodes the outputs depend on
+    std::vector<bool> needed(num_nodes, false);
+    std::vector<bool> is_output(num_nodes, false);
+    std::vector<NodeId> stack(outputs);
+    for (NodeId id : outputs)
+        is_output[id] = true;
+    while (!stack.empty()) {
+        const NodeId id = stack.back();
+        stack.pop_back();
+        if (needed[id])
+            continue;
+        needed[id] = true;
+        for (NodeId op : operands(id))
+            stack.push_back(op);
+    }
+    std::vector<u64> uses(num_nodes, 0);
+    for (NodeId id = 0; id < num_nodes; ++id) {
+        if (!needed[id])
+            continue;
+        const Node &node = nodes_[id];
+        if (node.op == OpType::INPUT &&
+            (node.ctxt->getLevel() != node.level ||
+             node.ctxt->getRescaleCounter() != 0))
+            throw RuntimeException("[GraphEvaluator::execute] An input "
+                                   "changed its level or rescale counter");
+        for (NodeId op : operands(id))
+            ++uses[op];
+    }
+
+    // Fuse sums of products whose results are used only by the sum. Users
+    // have larger ids than their operands, so the largest sums are found
+    // first.
+    std::vector<bool> absorbed(num_nodes, false);
+    std::map<NodeId, Fusion> fusions;
+    const auto is_private = [&](NodeId id) {
+        return uses[id] == 1 && !is_output[id];
+    };
+    const auto is_linear = [&](NodeId id) {
+        const OpType op = nodes_[id].op;
+        return op == OpType::ADD || op == OpType::SUB ||
+               op == OpType::NEGATE;
+    };
+    const auto is_product = [&](NodeId id) {
+        const Node &node = nodes_[id];
+        return node.op == OpType::MULT || node.op == OpType::SQUARE ||
+               node.op == OpType::MULT_PTXT ||
+               (node.op == OpType::MULT_CONST && !isGaussianInteger(node.cnst));
+    };
+    for (NodeId root = num_nodes; root-- > 0;) {
+        if (!needed[root] || absorbed[root] ||
+            (nodes_[root].op != OpType::ADD && nodes_[root].op != OpType::SUB))
+            continue;
+        Fusion fusion;
+        std::vector<NodeId> inner;
+        std::vector<std::pair<NodeId, bool>> pending{{root, false}};
+        while (!pending.empty()) {
+            const auto [id, negative] = pending.back();
+            pending.pop_back();
+            const Node &node = nodes_[id];
+            if (id == root || (is_private(id) && is_linear(id))) {
+                if (id != root)
+                    inner.push_back(id);
+                pending.emplace_back(node.lhs,
+                                     node.op == OpType::NEGATE ? !negative
+                                                               : negative);
+                if (node.op != OpType::NEGATE)
+                    pending.emplace_back(node.rhs, node.op == OpType::SUB
+                                                       ? !negative
+                                                       : negative);
+            } else if (is_private(id) && is_product(id)) {
+                fusion.products.emplace_back(id, negative);
+            } else {
+                fusion.others.emplace_back(id, negative);
+            }
+        }
+        if (fusion.products.size() < 2)
+            continue;
+        for (NodeId id : inner)
+            absorbed[id] = true;
+        for (const auto &product : fusion.products)
+            absorbed[product.first] = true;
+        fusions.emplace(root, std::move(fusion));
+    }
+
+    // Operands of each node as executed
+    std::vector<std::vector<NodeId>> deps(num_nodes);
+    std::vector<u64> wave(num_nodes, 0);
+    std::vector<u64> remaining_uses(num_nodes, 0);
+    u64 num_waves = 0;
+    for (NodeId id = 0; id < num_nodes; ++id) {
+        if (!needed[id] || absorbed[id] || nodes_[id].op == OpType::INPUT)
+            continue;
+        if (auto it = fusions.find(id); it != fusions.end()) {
+            for (const auto &[product, negative] : it->second.products)
+                for (NodeId op : operands(product))
+                    deps[id].push_back(op);
+            for (const auto &[other, negative] : it->second.others)
+                deps[id].push_back(other);
+        } else {
+            deps[id] = operands(id);
+        }
+        for (NodeId op : deps[id]) {
+            wave[id] = std::max(wave[id], wave[op] + 1);
+            ++remaining_uses[op];
+        }
+        num_waves = std::max(num_waves, wave[id]);
+    }
+
+    // Tasks of each wave. The rotations of a node all fall into the same
+    // wave, and are computed by a single task.
+    std::vector<std::vector<std::vector<NodeId>>> tasks(num_waves + 1);
+    std::map<std::pair<u64, NodeId>, u64> rotation_tasks;
+    for (NodeId id = 0; id < num_nodes; ++id) {
+        if (!needed[id] || absorbed[id] || nodes_[id].op == OpType::INPUT)
+            continue;
+        auto &wave_tasks = tasks[wave[id]];
+        if (nodes_[id].op == OpType::LEFT_ROTATE) {
+            const auto key = std::make_pair(wave[id], nodes_[id].lhs);
+            if (auto it = rotation_tasks.find(key);
+                it != rotation_tasks.end()) {
+                wave_tasks[it->second].push_back(id);
+                continue;
+            }
+            rotation_tasks.emplace(key, wave_tasks.size());
+        }
+        wave_tasks.push_back({id});
+    }
+
+    std::vector<std::unique_ptr<Ciphertext>> values(num_nodes);
+    std::vector<std::unique_ptr<Ciphertext>> recycled;
+    const auto value = [&](NodeId id) -> const Ciphertext & {
+        return nodes_[id].op == OpType::INPUT ? *nodes_[id].ctxt
+                                              : *values[id];
+    };
+
+    const auto run_fusion = [&](const Fusion &fusion, Ciphertext &ctxt_out) {
+        std::vector<const Ciphertext *> ptxt_ctxts;
+        std::vector<const Plaintext *> ptxts;
+        std::vector<const Ciphertext *> lhs_ctxts;
+        std::vector<const Ciphertext *> rhs_ctxts;
+        std::vector<std::pair<const Ciphertext *, Complex>> cnst_terms;
+        std::vector<Ciphertext> negated;
+        negated.reserve(fusion.products.size());
+        const auto signed_operand = [&](NodeId id, bool negative) {
+            if (!negative)
+                return &value(id);
+            negated.emplace_back(context);
+            eval_.negate(value(id), negated.back());
+            return static_cast<const Ciphertext *>(&negated.back());
+        };
+        for (const auto &[id, negative] : fusion.products) {
+            const Node &node = nodes_[id];
+            switch (node.op) {
+            case OpType::MULT_PTXT:
+                ptxt_ctxts.push_back(signed_operand(node.lhs, negative));
+                ptxts.push_back(node.ptxt);
+                break;
+            case OpType::MULT:
+            case OpType::SQUARE:
+                lhs_ctxts.push_back(signed_operand(node.lhs, negative));
+                rhs_ctxts.push_back(&value(
+                    node.op == OpType::SQUARE ? node.lhs : node.rhs));
+                break;
+            default:
+                cnst_terms.emplace_back(&value(node.lhs),
+                                        negative ? -node.cnst : node.cnst);
+                break;
+            }
+        }
+
+        Ciphertext result(context);
+        Ciphertext part(context);
+        bool is_first = true;
+        const auto accumulate = [&](Ciphertext &ctxt) {
+            if (is_first) {
+                std::swap(result, ctxt);
+                is_first = false;
+            } else {
+                eval_.add(result, ctxt, result);
+            }
+        };
+        if (!ptxts.empty()) {
+            detail::innerProduct(eval_, ptxt_ctxts, ptxts, part);
+            accumulate(part);
+        }
+        if (!lhs_ctxts.empty()) {
+            detail::innerProduct(eval_, lhs_ctxts, rhs_ctxts, part);
+            accumulate(part);
+        }
+        if (!cnst_terms.empty()) {
+            u64 level = std::numeric_limits<u64>::max();
+            for (const auto &term : cnst_terms)
+                level = std::min(level, term.first->getLevel());
+            Ciphertext leveled(context);
+            Ciphertext prod(context);
+            for (u64 i = 0; i < cnst_terms.size(); ++i) {
+                const Ciphertext *ctxt = cnst_terms[i].first;
+                if (ctxt->getLevel() != level) {
+                    eval_.levelDown(*ctxt, level, leveled);
+                    ctxt = &leveled;
+                }
+                eval_.multWithoutRescale(*ctxt, cnst_terms[i].second,
+                                         i == 0 ? part : prod);
+                if (i != 0)
+                    eval_.add(part, prod, part);
+            }
+            eval_.rescale(part);
+            accumulate(part);
+        }
+        for (const auto &[id, negative] : fusion.others) {
+            if (negative)
+                eval_.sub(result, value(id), result);
+            else
+                eval_.add(result, value(id), result);
+        }
+        ctxt_out = std::move(result);
+    };
+
+    const auto run_node = [&](NodeId id, Ciphertext &ctxt_out) {
+        if (auto it = fusions.find(id); it != fusions.end()) {
+            run_fusion(it->second, ctxt_out);
+            return;
+        }
+        const Node &node = nodes_[id];
+        switch (node.op) {
+        case OpType::ADD:
+            eval_.add(value(node.lhs), value(node.rhs), ctxt_out);
+            break;
+        case OpType::ADD_CONST:
+            eval_.add(value(node.lhs), node.cnst, ctxt_out);
+            break;
+        case OpType::SUB:
+            eval_.sub(value(node.lhs), value(node.rhs), ctxt_out);
+            break;
+        case OpType::NEGATE:
+            eval_.negate(value(node.lhs), ctxt_out);
+            break;
+        case OpType::MULT:
+            eval_.mult(value(node.lhs), value(node.rhs), ctxt_out);
+            break;
+        case OpType::MULT_PTXT:
+            eval_.mult(value(node.lhs), *node.ptxt, ctxt_out);
+            break;
+        case OpType::MULT_CONST:
+            eval_.mult(value(node.lhs), node.cnst, ctxt_out);
+            break;
+        case OpType::SQUARE:
+            eval_.square(value(node.lhs), ctxt_out);
+            break;
+        case OpType::LEFT_ROTATE:
+            eval_.leftRotate(value(node.lhs), node.param, ctxt_out);
+            break;
+        case OpType::LEVEL_DOWN:
+            eval_.levelDown(value(node.lhs), node.param, ctxt_out);
+            break;
+        case OpType::INPUT:
+            break;
+        }
+    };
+
+    for (u64 w = 1; w <= num_waves; ++w) {
+        const auto &wave_tasks = tasks[w];
+        for (const auto &task : wave_tasks) {
+            if (task.size() != 1)
+                continue;
+            if (recycled.empty()) {
+                values[task[0]] = std::make_unique<Ciphertext>(context);
+            } else {
+                values[task[0]] = std::move(recycled.back());
+                recycled.pop_back();
+            }
+        }
+        parallelFor(wave_tasks.size(), [&](u64 t) {
+            const auto &task = wave_tasks[t];
+            if (task.size() == 1) {
+                run_node(task[0], *values[task[0]]);
+                return;
+            }
+            std::vector<u64> rots;
+            rots.reserve(task.size());
+            for (NodeId id : task)
+                rots.push_back(nodes_[id].param);
+            std::vector<Ciphertext> rotated;
+            eval_.leftRotate(value(nodes_[task[0]].lhs), rots, rotated);
+            for (u64 i = 0; i < task.size(); ++i)
+                values[task[i]] =
+                    std::make_unique<Ciphertext>(std::move(rotated[i]));
+        });
+        // Recycle the results which have no consumer left
+        for (const auto &task : wave_tasks) {
+            for (NodeId id : task) {
+                for (NodeId op : deps[id]) {
+                    if (--remaining_uses[op] == 0 && !is_output[op] &&
+                        values[op] != nullptr)
+                        recycled.push_back(std::move(values[op]));
+                }
+            }
+        }
+    }
+
+    if (ctxts_out.size() > outputs.size())
+        ctxts_out.erase(ctxts_out.begin() + outputs.size(), ctxts_out.end());
+    while (ctxts_out.size() < outputs.size())
+        ctxts_out.emplace_back(context);
+    std::map<NodeId, u64> first_position;
+    for (u64 i = 0; i < outputs.size(); ++i) {
+        const NodeId id = outputs[i];
+        if (auto it = first_position.find(id); it != first_position.end()) {
+            ctxts_out[i] = ctxts_out[it->second];
+        } else if (nodes_[id].op == OpType::INPUT) {
+            ctxts_out[i] = *nodes_[id].ctxt;
+        } else {
+            ctxts_out[i] = std::move(*values[id]);
+            first_position.emplace(id, i);
+        }
+    }
+}
+
+} // namespace HEaaN
@@ -0,0 +1,362 @@
+////////////////////////////////////////////////////////////////////////////////
+//                                                                            //
+// Copyright (C) 2021-2023 Crypto Lab Inc.                                    //
+//                                                                            //
+// - This file is part of HEaaN homomorphic encryption library.               //
+// - HEaaN cannot be copied and/or distributed without the express permission //
+//  of Crypto Lab Inc.                                                        //
+//                                                                            //
+////////////////////////////////////////////////////////////////////////////////
+
+#include "HEaaN/HomEvaluator.hpp"
+
+#include <climits>
+#include <map>
+#include <optional>
+#include <string>
+
+#if defined(__GLIBC__)
+#include <malloc.h>
+#endif
+
+#include "HEaaN/BufferPool.hpp"
+#include "HEaaN/Ciphertext.hpp"
+#include "HEaaN/EncodeCache.hpp"
+#include "HEaaN/Exception.hpp"
+#include "HEaaN/Plaintext.hpp"
+#include "HEaaN/PreparedPlaintext.hpp"
+#include "InnerProduct.hpp"
+#include "ParallelFor.hpp"
+
+namespace HEaaN {
+
+namespace {
+
+// Group rotation amounts by their value modulo num_slots.
+std::map<u64, std::vector<u64>> groupRotations(const std::vector<u64> &rots,
+                                               u64 num_slots) {
+    std::map<u64, std::vector<u64>> groups;
+    for (u64 i = 0; i < rots.size(); ++i)
+        groups[rots[i] % num_slots].push_back(i);
+    return groups;
+}
+
+void checkBatchSize(const char *func, u64 size_in, u64 size_out) {
+    if (size_in != size_out)
+        throw RuntimeException(std::string{"["} + func +
+                               "] The numbers of input and output "
+                               "ciphertexts are different");
+}
+
+template <class T> std::vector<const T *> toPointers(Span<const T> objs) {
+    std::vector<const T *> ptrs(objs.size());
+    for (u64 i = 0; i < objs.size(); ++i)
+        ptrs[i] = &objs[i];
+    return ptrs;
+}
+
+template <class T>
+std::vector<const T *> toPointers(Span<const T *const> ptrs) {
+    return {ptrs.begin(), ptrs.end()};
+}
+
+void sumRotations(const HomEvaluator &eval,
+                  const std::vector<const Ciphertext *> &ctxts,
+                  const std::vector<u64> &rots, Ciphertext &ctxt_out) {
+    if (ctxts.size() != rots.size() || ctxts.empty())
+        throw RuntimeException("[rotSum] The numbers of ciphertexts and "
+                               "rotation amounts are different or zero");
+
+    const auto groups = groupRotations(rots, ctxts[0]->getNumberOfSlots());
+    std::vector<std::pair<u64, const std::vector<u64> *>> jobs;
+    std::vector<Ciphertext> partials;
+    jobs.reserve(groups.size());
+    partials.reserve(groups.size());
+    for (const auto &[rot, indices] : groups) {
+        jobs.emplace_back(rot, &indices);
+        partials.emplace_back(eval.getContext());
+    }
+
+    // Each group is summed before its single rotation. A group of one input
+    // which is not rotated is used as is.
+    std::vector<const Ciphertext *> terms(jobs.size());
+    parallelFor(jobs.size(), [&](u64 i) {
+        const u64 rot = jobs[i].first;
+        const auto &indices = *jobs[i].second;
+        Ciphertext &partial = partials[i];
+        const Ciphertext *term = ctxts[indices.front()];
+        if (indices.size() > 1) {
+            eval.add(*ctxts[indices[0]], *ctxts[indices[1]], partial);
+            for (u64 j = 2; j < indices.size(); ++j)
+                eval.add(partial, *ctxts[indices[j]], partial);
+            term = &partial;
+        }
+        if (rot != 0) {
+            eval.leftRotate(*term, rot, partial);
+            term = &partial;
+        }
+        terms[i] = term;
+    });
+
+    if (terms.size() == 1) {
+        if (terms[0] == &partials[0])
+            ctxt_out = std::move(partials[0]);
+        else if (terms[0] != &ctxt_out)
+            ctxt_out = *terms[0];
+        return;
+    }
+    Ciphertext result(eval.getContext());
+    eval.add(*terms[0], *terms[1], result);
+    for (u64 i = 2; i < terms.size(); ++i)
+        eval.add(result, *terms[i], result);
+    ctxt_out = std::move(result);
+}
+
+} // namespace
+
+void HomEvaluator::leftRotate(const Ciphertext &ctxt,
+                              const std::vector<u64> &rots,
+                              std::vector<Ciphertext> &ctxts_out) const {
+    // ctxt may be an element of ctxts_out, which is resized and written below.
+    std::optional<Ciphertext> input_copy;
+    for (const Ciphertext &out : ctxts_out)
+        if (&out == &ctxt)
+            input_copy.emplace(ctxt);
+    const Ciphertext &input = input_copy ? *input_copy : ctxt;
+
+    if (ctxts_out.size() > rots.size())
+        ctxts_out.erase(ctxts_out.begin() + rots.size(), ctxts_out.end());
+    while (ctxts_out.size() < rots.size())
+        ctxts_out.emplace_back(context_);
+
+    const auto groups = groupRotations(rots, input.getNumberOfSlots());
+    std::vector<std::pair<u64, const std::vector<u64> *>> jobs;
+    jobs.reserve(groups.size());
+    for (const auto &[rot, indices] : groups)
+        jobs.emplace_back(rot, &indices);
+
+    parallelFor(jobs.size(), [&](u64 i) {
+        const u64 rot = jobs[i].first;
+        const auto &indices = *jobs[i].second;
+        Ciphertext &first = ctxts_out[indices.front()];
+        if (rot == 0)
+            first = input;
+        else
+            leftRotate(input, rot, first);
+        for (u64 j = 1; j < indices.size(); ++j)
+            ctxts_out[indices[j]] = first;
+    });
+}
+
+void HomEvaluator::add(Span<const Ciphertext> ctxts1,
+                       Span<const Ciphertext> ctxts2,
+                       Span<Ciphertext> ctxts_out) const {
+    checkBatchSize("add", ctxts1.size(), ctxts2.size());
+    checkBatchSize("add", ctxts1.size(), ctxts_out.size());
+    parallelFor(ctxts_out.size(),
+                [&](u64 i) { add(ctxts1[i], ctxts2[i], ctxts_out[i]); });
+}
+
+void HomEvaluator::sub(Span<const Ciphertext> ctxts1,
+                       Span<const Ciphertext> ctxts2,
+                       Span<Ciphertext> ctxts_out) const {
+    checkBatchSize("sub", ctxts1.size(), ctxts2.size());
+    checkBatchSize("sub", ctxts1.size(), ctxts_out.size());
+    parallelFor(ctxts_out.size(),
+                [&](u64 i) { sub(ctxts1[i], ctxts2[i], ctxts_out[i]); });
+}
+
+void HomEvaluator::mult(Span<const Ciphertext> ctxts1,
+                        Span<const Ciphertext> ctxts2,
+                        Span<Ciphertext> ctxts_out) const {
+    checkBatchSize("mult", ctxts1.size(), ctxts2.size());
+    checkBatchSize("mult", ctxts1.size(), ctxts_out.size());
+    parallelFor(ctxts_out.size(),
+                [&](u64 i) { mult(ctxts1[i], ctxts2[i], ctxts_out[i]); });
+}
+
+void HomEvaluator::square(Span<const Ciphertext> ctxts,
+                          Span<Ciphertext> ctxts_out) const {
+    checkBatchSize("square", ctxts.size(), ctxts_out.size());
+    parallelFor(ctxts_out.size(),
+                [&](u64 i) { square(ctxts[i], ctxts_out[i]); });
+}
+
+void HomEvaluator::leftRotate(Span<const Ciphertext> ctxts, u64 rot,
+                              Span<Ciphertext> ctxts_out) const {
+    checkBatchSize("leftRotate", ctxts.size(), ctxts_out.size());
+    parallelFor(ctxts_out.size(),
+                [&](u64 i) { leftRotate(ctxts[i], rot, ctxts_out[i]); });
+}
+
+void HomEvaluator::rescale(Span<Ciphertext> ctxts) const {
+    parallelFor(ctxts.size(), [&](u64 i) { rescale(ctxts[i]); });
+}
+
+void HomEvaluator::levelDown(Span<const Ciphertext> ctxts, u64 target_level,
+                             Span<Ciphertext> ctxts_out) const {
+    checkBatchSize("levelDown", ctxts.size(), ctxts_out.size());
+    parallelFor(ctxts_out.size(), [&](u64 i) {
+        levelDown(ctxts[i], target_level, ctxts_out[i]);
+    });
+}
+
+void HomEvaluator::innerProduct(Span<const Ciphertext> ctxts,
+                                Span<const Plaintext> ptxts,
+                                Ciphertext &ctxt_out) const {
+    detail::innerProduct(*this, toPointers(ctxts), toPointers(ptxts),
+                         ctxt_out);
+}
+
+void HomEvaluator::innerProduct(Span<const Ciphertext> ctxts1,
+                                Span<const Ciphertext> ctxts2,
+                                Ciphertext &ctxt_out) const {
+    detail::innerProduct(*this, toPointers(ctxts1), toPointers(ctxts2),
+                         ctxt_out);
+}
+
+void HomEvaluator::add(const Ciphertext &ctxt1, const Message &msg2,
+                       EncodeCache &cache, Ciphertext &ctxt_out) const {
+    const auto ptxt2 =
+        cache.encode(msg2, ctxt1.getLevel(), ctxt1.getRescaleCounter());
+    add(ctxt1, *ptxt2, ctxt_out);
+}
+
+void HomEvaluator::sub(const Ciphertext &ctxt1, const Message &msg2,
+                       EncodeCache &cache, Ciphertext &ctxt_out) const {
+    const auto ptxt2 =
+        cache.encode(msg2, ctxt1.getLevel(), ctxt1.getRescaleCounter());
+    sub(ctxt1, *ptxt2, ctxt_out);
+}
+
+void HomEvaluator::mult(const Ciphertext &ctxt1, const Message &msg2,
+                        EncodeCache &cache, Ciphertext &ctxt_out) const {
+    if (ctxt1.getRescaleCounter() != 0)
+        throw RuntimeException("[HomEvaluator::mult] Rescale counter of the "
+                               "ciphertext should be zero");
+    const auto ptxt2 = cache.encode(msg2, ctxt1.getLevel());
+    mult(ctxt1, *ptxt2, ctxt_out);
+}
+
+void HomEvaluator::add(const Ciphertext &ctxt1,
+                       const PreparedPlaintext &ptxt2,
+                       Ciphertext &ctxt_out) const {
+    add(ctxt1, *ptxt2.getPlaintext(ctxt1.getLevel()), ctxt_out);
+}
+
+void HomEvaluator::sub(const Ciphertext &ctxt1,
+                       const PreparedPlaintext &ptxt2,
+                       Ciphertext &ctxt_out) const {
+    sub(ctxt1, *ptxt2.getPlaintext(ctxt1.getLevel()), ctxt_out);
+}
+
+void HomEvaluator::mult(const Ciphertext &ctxt1,
+                        const PreparedPlaintext &ptxt2,
+                        Ciphertext &ctxt_out) const {
+    mult(ctxt1, *ptxt2.getPlaintext(ctxt1.getLevel()), ctxt_out);
+}
+
+void HomEvaluator::multWithoutRescale(const Ciphertext &ctxt1,
+                                      const PreparedPlaintext &ptxt2,
+                                      Ciphertext &ctxt_out) const {
+    multWithoutRescale(ctxt1, *ptxt2.getPlaintext(ctxt1.getLevel()),
+                       ctxt_out);
+}
+
+void HomEvaluator::innerProduct(Span<const Ciphertext *const> ctxts,
+                                Span<const Plaintext *const> ptxts,
+                                Ciphertext &ctxt_out) const {
+    detail::innerProduct(*this, toPointers(ctxts), toPointers(ptxts),
+                         ctxt_out);
+}
+
+void HomEvaluator::innerProduct(Span<const Ciphertext *const> ctxts1,
+                                Span<const Ciphertext *const> ctxts2,
+                                Ciphertext &ctxt_out) const {
+    detail::innerProduct(*this, toPointers(ctxts1), toPointers(ctxts2),
+                         ctxt_out);
+}
+
+void HomEvaluator::rotSum(Span<const Ciphertext> ctxts,
+                          const std::vector<u64> &rots,
+                          Ciphertext &ctxt_out) const {
+    sumRotations(*this, toPointers(ctxts), rots, ctxt_out);
+}
+
+void HomEvaluator::rotSum(Span<const Ciphertext *const> ctxts,
+                          const std::vector<u64> &rots,
+                          Ciphertext &ctxt_out) const {
+    sumRotations(*this, toPointers(ctxts), rots, ctxt_out);
+}
+
+void HomEvaluator::addInplace(Ciphertext &ctxt,
+                              const Ciphertext &ctxt2) const {
+    add(ctxt, ctxt2, ctxt);
+}
+
+void HomEvaluator::addInplace(Ciphertext &ctxt, const Plaintext &ptxt) const {
+    add(ctxt, ptxt, ctxt);
+}
+
+void HomEvaluator::addInplace(Ciphertext &ctxt,
+                              const Complex &cnst_complex) const {
+    add(ctxt, cnst_complex, ctxt);
+}
+
+void HomEvaluator::multInplace(Ciphertext &ctxt,
+                               const Ciphertext &ctxt2) const {
+    mult(ctxt, ctxt2, ctxt);
+}
+
+void HomEvaluator::multInplace(Ciphertext &ctxt, const Plaintext &ptxt) const {
+    mult(ctxt, ptxt, ctxt);
+}
+
+void HomEvaluator::multInplace(Ciphertext &ctxt,
+                               const Complex &cnst_complex) const {
+    mult(ctxt, cnst_complex, ctxt);
+}
+
+void HomEvaluator::rotateInplace(Ciphertext &ctxt, u64 rot) const {
+    leftRotate(ctxt, rot, ctxt);
+}
+
+void HomEvaluator::rescaleInplace(Ciphertext &ctxt) const { rescale(ctxt); }
+
+void HomEvaluator::reserveWorkspace(u64 num_threads, u64 max_level) const {
+    Ciphertext probe(context_);
+    if (num_threads == 0)
+        throw RuntimeException("[reserveWorkspace] The number of threads "
+                               "should be positive");
+    if (max_level > probe.getLevel())
+        throw RuntimeException("[reserveWorkspace] The level exceeds the "
+                               "maximal level of a ciphertext");
+
+    // prefault zero-fills the residues, so the probe is a valid encryption
+    // of zero.
+    probe.setLevel(max_level);
+    probe.setRescaleCounter(0);
+    detail::prefault(context_, probe);
+    parallelForEachThread(num_threads, [&](u64) {
+        Ciphertext out(context_);
+        mult(probe, probe, out);
+    });
+}
+
+bool tuneAllocatorForKeySwitching(u64 max_arenas) {
+    if (max_arenas == 0)
+        throw RuntimeException("[tuneAllocatorForKeySwitching] The number of "
+                               "arenas should be positive");
+#if defined(__GLIBC__)
+    // Keep freed blocks of up to 32 MiB, the largest threshold glibc accepts,
+    // in the arenas rather than unmapping them, and never give the top of an
+    // arena back to the system.
+    return mallopt(M_MMAP_THRESHOLD, 32 << 20) == 1 &&
+           mallopt(M_TRIM_THRESHOLD, INT_MAX) == 1 &&
+           mallopt(M_ARENA_MAX, static_cast<int>(max_arenas)) == 1;
+#else
+    return false;
+#endif
+}
+
+} // namespace HEaaN
@@ -0,0 +1,269 @@
+////////////////////////////////////////////////////////////////////////////////
+//                                                                            //
+// Copyright (C) 2021-2023 Crypto Lab Inc.                                    //
+//                                                                            //
+// - This file is part of HEaaN homomorphic encryption library.               //
+// - HEaaN cannot be copied and/or distributed without the express permission //
+//  of Crypto Lab Inc.                                                        //
+//                                                                            //
+////////////////////////////////////////////////////////////////////////////////
+
+#include "InnerProduct.hpp"
+
+#include <algorithm>
+
+#include "ContextUtil.hpp"
+#include "HEaaN/Exception.hpp"
+#include "Modulus.hpp"
+#include "ParallelFor.hpp"
+
+namespace HEaaN::detail {
+
+namespace {
+
+// Number of coefficients accumulated at once, so that the accumulators stay
+// in the L1 cache while all the terms stream through them.
+constexpr u64 BLOCK_SIZE = 256;
+
+// out[j] = Σ_k lhs[k][j] * rhs[k][j] (mod prime) for 0 <= j < degree.
+// Products are accumulated lazily in blocks of coefficients and reduced once
+// every lazyReductionInterval() terms.
+void accumulateProducts(const std::vector<const u64 *> &lhs,
+                        const std::vector<const u64 *> &rhs,
+                        const Modulus &modulus, u64 degree, u64 *out) {
+    const u64 interval = modulus.lazyReductionInterval();
+    u128 acc[BLOCK_SIZE];
+    for (u64 begin = 0; begin < degree; begin += BLOCK_SIZE) {
+        const u64 size = std::min(BLOCK_SIZE, degree - begin);
+        std::fill(acc, acc + size, 0);
+        for (u64 k = 0; k < lhs.size(); ++k) {
+            const u64 *a = lhs[k] + begin;
+            const u64 *b = rhs[k] + begin;
+            for (u64 j = 0; j < size; ++j)
+                acc[j] += static_cast<u128>(a[j]) * b[j];
+            if ((k + 1) % interval == 0)
+                for (u64 j = 0; j < size; ++j)
+                    acc[j] = modulus.reduce(acc[j]);
+        }
+        for (u64 j = 0; j < size; ++j)
+            out[begin + j] = modulus.reduce(acc[j]);
+    }
+}
+
+// Moduli of the primes up to level
+std::vector<Modulus> makeModuli(const Context &context, u64 level) {
+    const auto primes = getPrimeList(context);
+    return {primes.begin(), primes.begin() + level + 1};
+}
+
+// Whether the buffers of ctxt can hold the result at level
+bool canWriteInPlace(const Ciphertext &ctxt, u64 level) {
+    return isOnCPU(ctxt.getDevice()) && !ctxt.isModUp() &&
+           ctxt.getSize() == 2 && ctxt.getLevel() >= level;
+}
+
+// ctxt_out = Σ cts[k] * pts[k] at level, without rescaling. The operands are
+// on CPU at level.
+void sumOfProducts(const Context &context,
+                   const std::vector<const Ciphertext *> &cts,
+                   const std::vector<const Plaintext *> &pts, u64 level,
+                   Ciphertext &ctxt_out) {
+    const auto moduli = makeModuli(context, level);
+    const u64 degree = getDegree(context);
+    const u64 num_terms = cts.size();
+    const u64 log_slots = cts[0]->getLogSlots();
+    ctxt_out.setLevel(level);
+    parallelFor(2 * (level + 1), [&](u64 job) {
+        const u64 poly = job / (level + 1);
+        const u64 l = job % (level + 1);
+        std::vector<const u64 *> lhs(num_terms);
+        std::vector<const u64 *> rhs(num_terms);
+        for (u64 k = 0; k < num_terms; ++k) {
+            lhs[k] = cts[k]->getPolyData(poly, l);
+            rhs[k] = pts[k]->getMxData(l);
+        }
+        accumulateProducts(lhs, rhs, moduli[l], degree,
+                           ctxt_out.getPolyData(poly, l));
+    });
+    ctxt_out.setLogSlots(log_slots);
+    ctxt_out.setRescaleCounter(1);
+}
+
+// Pointers to ctxts brought down to level. The adjusted copies are kept in
+// storage, which is reserved up front so that the pointers stay valid.
+std::vector<const Ciphertext *>
+matchLevel(const HomEvaluator &eval,
+           const std::vector<const Ciphertext *> &ctxts, u64 level,
+           std::vector<Ciphertext> &storage) {
+    storage.reserve(ctxts.size());
+    std::vector<const Ciphertext *> leveled(ctxts);
+    for (auto &ctxt : leveled) {
+        if (ctxt->getLevel() != level) {
+            storage.emplace_back(eval.getContext());
+            eval.levelDown(*ctxt, level, storage.back());
+            ctxt = &storage.back();
+        }
+    }
+    return leveled;
+}
+
+std::vector<const Plaintext *>
+matchLevel(const HomEvaluator &eval,
+           const std::vector<const Plaintext *> &ptxts, u64 level,
+           std::vector<Plaintext> &storage) {
+    storage.reserve(ptxts.size());
+    std::vector<const Plaintext *> leveled(ptxts);
+    for (auto &ptxt : leveled) {
+        if (ptxt->getLevel() != level) {
+            storage.emplace_back(eval.getContext());
+            eval.relevel(*ptxt, level, storage.back());
+            ptxt = &storage.back();
+        }
+    }
+    return leveled;
+}
+
+} // namespace
+
+void innerProduct(const HomEvaluator &eval,
+                  const std::vector<const Ciphertext *> &ctxts,
+                  const std::vector<const Plaintext *> &ptxts,
+                  Ciphertext &ctxt_out) {
+    if (ctxts.size() != ptxts.size() || ctxts.empty())
+        throw RuntimeException("[innerProduct] The numbers of ciphertexts and "
+                               "plaintexts are different or zero");
+
+    const Context &context = eval.getContext();
+    const u64 num_terms = ctxts.size();
+    u64 level = ctxts[0]->getLevel();
+    bool on_cpu = true;
+    for (u64 k = 0; k < num_terms; ++k) {
+        if (ctxts[k]->getRescaleCounter() != 0 ||
+            ptxts[k]->getRescaleCounter() != 0)
+            throw RuntimeException("[innerProduct] Rescale counter of the "
+                                   "operands should be zero");
+        level = std::min({level, ctxts[k]->getLevel(), ptxts[k]->getLevel()});
+        on_cpu = on_cpu && isOnCPU(ctxts[k]->getDevice()) &&
+                 isOnCPU(ptxts[k]->getDevice()) && !ctxts[k]->isModUp();
+    }
+
+    // A single product is left to the vectorized kernel of the library.
+    if (num_terms == 1) {
+        eval.mult(*ctxts[0], *ptxts[0], ctxt_out);
+        return;
+    }
+
+    std::vector<Ciphertext> leveled_ctxts;
+    std::vector<Plaintext> releveled_ptxts;
+    const auto cts = matchLevel(eval, ctxts, level, leveled_ctxts);
+    const auto pts = matchLevel(eval, ptxts, level, releveled_ptxts);
+
+    if (on_cpu && canWriteInPlace(ctxt_out, level)) {
+        // Each job reads and writes only one residue of one part, and reads a
+        // block of every operand before writing it, so ctxt_out may alias any
+        // of the operands.
+        sumOfProducts(context, cts, pts, level, ctxt_out);
+        eval.rescale(ctxt_out);
+        return;
+    }
+
+    Ciphertext result(context);
+    if (on_cpu) {
+        sumOfProducts(context, cts, pts, level, result);
+    } else {
+        Ciphertext prod(context);
+        eval.multWithoutRescale(*cts[0], *pts[0], result);
+        for (u64 k = 1; k < num_terms; ++k) {
+            eval.multWithoutRescale(*cts[k], *pts[k], prod);
+            eval.add(result, prod, result);
+        }
+    }
+    eval.rescale(result);
+    ctxt_out = std::move(result);
+}
+
+void innerProduct(const HomEvaluator &eval,
+                  const std::vector<const Ciphertext *> &ctxts1,
+                  const std::vector<const Ciphertext *> &ctxts2,
+                  Ciphertext &ctxt_out) {
+    if (ctxts1.size() != ctxts2.size() || ctxts1.empty())
+        throw RuntimeException("[innerProduct] The numbers of ciphertexts are "
+                               "different or zero");
+
+    const Context &context = eval.getContext();
+    const u64 num_terms = ctxts1.size();
+    u64 level = ctxts1[0]->getLevel();
+    bool on_cpu = true;
+    for (u64 k = 0; k < num_terms; ++k) {
+        if (ctxts1[k]->getRescaleCounter() != 0 ||
+            ctxts2[k]->getRescaleCounter() != 0)
+            throw RuntimeException("[innerProduct] Rescale counter of the "
+                                   "operands should be zero");
+        if (ctxts1[k]->getSize() != 2 || ctxts2[k]->getSize() != 2)
+            throw RuntimeException("[innerProduct] Size of the operands "
+                                   "should be 2");
+        level =
+            std::min({level, ctxts1[k]->getLevel(), ctxts2[k]->getLevel()});
+        on_cpu = on_cpu && isOnCPU(ctxts1[k]->getDevice()) &&
+                 isOnCPU(ctxts2[k]->getDevice()) && !ctxts1[k]->isModUp() &&
+                 !ctxts2[k]->isModUp();
+    }
+
+    if (num_terms == 1) {
+        eval.mult(*ctxts1[0], *ctxts2[0], ctxt_out);
+        return;
+    }
+
+    std::vector<Ciphertext> leveled_ctxts1;
+    std::vector<Ciphertext> leveled_ctxts2;
+    const auto cts1 = matchLevel(eval, ctxts1, level, leveled_ctxts1);
+    const auto cts2 = matchLevel(eval, ctxts2, level, leveled_ctxts2);
+
+    // Accumulate the tensor products (b1b2, a1b2 + a2b1, a1a2) of all the
+    // pairs, so that only one relinearization is needed.
+    Ciphertext tensored(context);
+    if (on_cpu) {
+        const auto moduli = makeModuli(context, level);
+        const u64 degree = getDegree(context);
+        tensored.setSize(3);
+        tensored.setLevel(level);
+        tensored.setLogSlots(cts1[0]->getLogSlots());
+        parallelFor(3 * (level + 1), [&](u64 job) {
+            const u64 poly = job / (level + 1);
+            const u64 l = job % (level + 1);
+            std::vector<const u64 *> lhs;
+            std::vector<const u64 *> rhs;
+            lhs.reserve(2 * num_terms);
+            rhs.reserve(2 * num_terms);
+            for (u64 k = 0; k < num_terms; ++k) {
+                if (poly == 1) {
+                    lhs.push_back(cts1[k]->getPolyData(0, l));
+                    rhs.push_back(cts2[k]->getPolyData(1, l));
+                    lhs.push_back(cts1[k]->getPolyData(1, l));
+                    rhs.push_back(cts2[k]->getPolyData(0, l));
+                } else {
+                    const u64 part = poly / 2;
+                    lhs.push_back(cts1[k]->getPolyData(part, l));
+                    rhs.push_back(cts2[k]->getPolyData(part, l));
+                }
+            }
+            accumulateProducts(lhs, rhs, moduli[l], degree,
+                               tensored.getPolyData(poly, l));
+        });
+        tensored.setRescaleCounter(1);
+    } else {
+        Ciphertext prod(context);
+        eval.tensor(*cts1[0], *cts2[0], tensored);
+        for (u64 k = 1; k < num_terms; ++k) {
+            eval.tensor(*cts1[k], *cts2[k], prod);
+            eval.add(tensored, prod, tensored);
+        }
+    }
+
+    Ciphertext result(context);
+    eval.relinearize(tensored, result);
+    eval.rescale(result);
+    ctxt_out = std::move(result);
+}
+
+} // namespace HEaaN::detail
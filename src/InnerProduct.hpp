@@ -0,0 +1,38 @@
+////////////////////////////////////////////////////////////////////////////////
+//                                                                            //
+// Copyright (C) 2021-2023 Crypto Lab Inc.                                    //
+//                                                                            //
+// - This file is part of HEaaN homomorphic encryption library.               //
+// - HEaaN cannot be copied and/or distributed without the express permission //
+//  of Crypto Lab Inc.                                                        //
+//                                                                            //
+////////////////////////////////////////////////////////////////////////////////
+
+#pragma once
+
+#include <vector>
+
+#include "HEaaN/Ciphertext.hpp"
+#include "HEaaN/HomEvaluator.hpp"
+#include "HEaaN/Plaintext.hpp"
+
+namespace HEaaN::detail {
+
+///@brief Compute Σ ctxts[i] * ptxts[i] with a single rescale
+///@details Backend of HomEvaluator::innerProduct, which takes its operands by
+/// pointer so that callers can pick them out of larger collections.
+void innerProduct(const HomEvaluator &eval,
+                  const std::vector<const Ciphertext *> &ctxts,
+                  const std::vector<const Plaintext *> &ptxts,
+                  Ciphertext &ctxt_out);
+
+///@brief Compute Σ ctxts1[i] * ctxts2[i] with a single relinearization and
+/// rescale
+///@details Backend of HomEvaluator::innerProduct, which takes its operands by
+/// pointer so that callers can pick them out of larger collections.
+void innerProduct(const HomEvaluator &eval,
+                  const std::vector<const Ciphertext *> &ctxts1,
+                  const std::vector<const Ciphertext *> &ctxts2,
+                  Ciphertext &ctxt_out);
+
+} // namespace HEaaN::detail
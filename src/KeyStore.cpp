@@ -0,0 +1,145 @@
+////////////////////////////////////////////////////////////////////////////////
+//                                                                            //
+// Copyright (C) 2021-2023 Crypto Lab Inc.                                    //
+//                                                                            //
+// - This file is part of HEaaN homomorphic encryption library.               //
+// - HEaaN cannot be copied and/or distributed without the express permission //
+//  of Crypto Lab Inc.                                                        //
+//                                                                            //
+////////////////////////////////////////////////////////////////////////////////
+
+#include "HEaaN/KeyStore.hpp"
+
+#include <algorithm>
+#include <charconv>
+#include <filesystem>
+#include <istream>
+#include <system_error>
+
+#include "HEaaN/Exception.hpp"
+#include "MappedFile.hpp"
+
+namespace HEaaN {
+
+namespace {
+
+// File names used by KeyGenerator::save and KeyPack::save
+const std::string ENC_KEY_FILE = "EncKey.bin";
+const std::string MULT_KEY_FILE = "MultKey.bin";
+const std::string CONJ_KEY_FILE = "ConjKey.bin";
+const std::string SSE_KEY_FILE = "SparseSecretEncapsulationKey.bin";
+const std::string ROT_KEY_PREFIX = "RotKey";
+const std::string KEY_SUFFIX = ".bin";
+
+std::string getRotKeyFile(u64 rot) {
+    return ROT_KEY_PREFIX + std::to_string(rot) + KEY_SUFFIX;
+}
+
+// Index of a rotation key file name, or false if it is not one
+bool parseRotKeyFile(const std::string &name, u64 &rot) {
+    if (name.size() <= ROT_KEY_PREFIX.size() + KEY_SUFFIX.size() ||
+        name.compare(0, ROT_KEY_PREFIX.size(), ROT_KEY_PREFIX) != 0 ||
+        name.compare(name.size() - KEY_SUFFIX.size(), KEY_SUFFIX.size(),
+                     KEY_SUFFIX) != 0)
+        return false;
+    // Digits only, and within u64; other names are stray files.
+    const char *first = name.data() + ROT_KEY_PREFIX.size();
+    const char *last = name.data() + name.size() - KEY_SUFFIX.size();
+    const auto [ptr, ec] = std::from_chars(first, last, rot);
+    return ec == std::errc{} && ptr == last;
+}
+
+// Run load(stream) with a stream reading the mapped file at path
+template <class Load> void loadMapped(const std::string &path, Load &&load) {
+    const detail::MappedFile file(path);
+    detail::MemoryStreamBuf buf(file.data(), file.size());
+    std::istream stream(&buf);
+    load(stream);
+}
+
+} // namespace
+
+KeyStore::KeyStore(const std::string &key_dir_path)
+    : key_dir_path_{key_dir_path} {
+    if (!std::filesystem::is_directory(key_dir_path_ + "/PK"))
+        throw RuntimeException("[KeyStore] " + key_dir_path_ +
+                               "/PK is not a directory");
+}
+
+bool KeyStore::hasLeftRotKey(u64 rot) const {
+    return std::filesystem::is_regular_file(getPath(getRotKeyFile(rot)));
+}
+
+std::vector<u64> KeyStore::getLeftRotKeyIndices() const {
+    std::vector<u64> indices;
+    for (const auto &entry :
+         std::filesystem::directory_iterator(key_dir_path_ + "/PK")) {
+        u64 rot;
+        if (entry.is_regular_file() &&
+            parseRotKeyFile(entry.path().filename().string(), rot))
+            indices.push_back(rot);
+    }
+    std::sort(indices.begin(), indices.end());
+    return indices;
+}
+
+u64 KeyStore::getLeftRotKeySize(u64 rot) const {
+    std::error_code error;
+    const auto size =
+        std::filesystem::file_size(getPath(getRotKeyFile(rot)), error);
+    if (error)
+        throw RuntimeException("[KeyStore::getLeftRotKeySize] No left "
+                               "rotation key by " +
+                               std::to_string(rot));
+    return static_cast<u64>(size);
+}
+
+void KeyStore::loadEncKey(KeyPack &keypack) const {
+    loadMapped(getPath(ENC_KEY_FILE),
+               [&](std::istream &stream) { keypack.loadEncKey(stream); });
+}
+
+void KeyStore::loadMultKey(KeyPack &keypack) const {
+    loadMapped(getPath(MULT_KEY_FILE),
+               [&](std::istream &stream) { keypack.loadMultKey(stream); });
+}
+
+void KeyStore::loadConjKey(KeyPack &keypack) const {
+    loadMapped(getPath(CONJ_KEY_FILE),
+               [&](std::istream &stream) { keypack.loadConjKey(stream); });
+}
+
+void KeyStore::loadLeftRotKey(KeyPack &keypack, u64 rot) const {
+    loadMapped(getPath(getRotKeyFile(rot)), [&](std::istream &stream) {
+        keypack.loadLeftRotKey(rot, stream);
+    });
+}
+
+bool KeyStore::hasSparseSecretEncapsulationKey() const {
+    return std::filesystem::is_regular_file(getPath(SSE_KEY_FILE));
+}
+
+void KeyStore::loadSparseSecretEncapsulationKey(KeyPack &keypack) const {
+    loadMapped(getPath(SSE_KEY_FILE), [&](std::istream &stream) {
+        keypack.loadSparseSecretEncapsulationKey(stream);
+    });
+}
+
+void KeyStore::loadAll(KeyPack &keypack) const {
+    if (std::filesystem::is_regular_file(getPath(ENC_KEY_FILE)))
+        loadEncKey(keypack);
+    if (std::filesystem::is_regular_file(getPath(MULT_KEY_FILE)))
+        loadMultKey(keypack);
+    if (std::filesystem::is_regular_file(getPath(CONJ_KEY_FILE)))
+        loadConjKey(keypack);
+    if (hasSparseSecretEncapsulationKey())
+        loadSparseSecretEncapsulationKey(keypack);
+    for (const u64 rot : getLeftRotKeyIndices())
+        loadLeftRotKey(keypack, rot);
+}
+
+std::string KeyStore::getPath(const std::string &name) const {
+    return key_dir_path_ + "/PK/" + name;
+}
+
+} // namespace HEaaN
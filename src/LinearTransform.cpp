@@ -0,0 +1,176 @@
+////////////////////////////////////////////////////////////////////////////////
+//                                                                            //
+// Copyright (C) 2021-2023 Crypto Lab Inc.                                    //
+//                                                                            //
+// - This file is part of HEaaN homomorphic encryption library.               //
+// - HEaaN cannot be copied and/or distributed without the express permission //
+//  of Crypto Lab Inc.                                                        //
+//                                                                            //
+////////////////////////////////////////////////////////////////////////////////
+
+#include "HEaaN/LinearTransform.hpp"
+
+#include <algorithm>
+#include <limits>
+#include <set>
+
+#include "HEaaN/Ciphertext.hpp"
+#include "HEaaN/EnDecoder.hpp"
+#include "HEaaN/Exception.hpp"
+#include "HEaaN/Message.hpp"
+#include "InnerProduct.hpp"
+
+namespace HEaaN {
+
+namespace {
+
+bool isPowerOfTwo(u64 n) { return n != 0 && (n & (n - 1)) == 0; }
+
+u64 log2Exact(u64 n) { return static_cast<u64>(__builtin_ctzll(n)); }
+
+// Number of rotations needed by BSGS with baby step b for the diagonals
+u64 countRotations(const std::vector<u64> &diagonals, u64 baby_step) {
+    std::set<u64> baby;
+    std::set<u64> giant;
+    for (u64 k : diagonals) {
+        if (k % baby_step != 0)
+            baby.insert(k % baby_step);
+        if (k / baby_step != 0)
+            giant.insert(k / baby_step);
+    }
+    return baby.size() + giant.size();
+}
+
+} // namespace
+
+LinearTransform::LinearTransform(const HomEvaluator &eval,
+                                 const Matrix &matrix, u64 level)
+    : eval_{eval}, level_{level}, baby_step_{1} {
+    const Context &context = eval.getContext();
+    const u64 dim = matrix.size();
+    if (!isPowerOfTwo(dim) || dim > (U64ONE << getLogFullSlots(context)))
+        throw RuntimeException("[LinearTransform] The size of the matrix "
+                               "should be a power of two not exceeding the "
+                               "number of full slots");
+    for (const auto &row : matrix)
+        if (row.size() != dim)
+            throw RuntimeException(
+                "[LinearTransform] The matrix should be square");
+    if (level == 0 || level > getEncryptionLevel(context))
+        throw RuntimeException("[LinearTransform] The level should be "
+                               "positive and should not exceed the "
+                               "encryption level");
+    log_slots_ = log2Exact(dim);
+
+    const auto entry = [&](u64 row, u64 diag) -> const Complex & {
+        return matrix[row][(row + diag) % dim];
+    };
+    std::vector<u64> nonzero;
+    for (u64 k = 0; k < dim; ++k) {
+        for (u64 j = 0; j < dim; ++j) {
+            if (entry(j, k) != COMPLEX_ZERO) {
+                nonzero.push_back(k);
+                break;
+            }
+        }
+    }
+    // Keep the main diagonal of a zero matrix so that apply() still yields a
+    // ciphertext at the expected level.
+    if (nonzero.empty())
+        nonzero.push_back(0);
+
+    u64 min_rotations = std::numeric_limits<u64>::max();
+    for (u64 b = 1; b <= dim; b <<= 1) {
+        const u64 num_rotations = countRotations(nonzero, b);
+        if (num_rotations < min_rotations) {
+            min_rotations = num_rotations;
+            baby_step_ = b;
+        }
+    }
+
+    EnDecoder encoder(context);
+    std::set<u64> baby_indices;
+    for (u64 k : nonzero) {
+        const u64 giant = k / baby_step_;
+        const u64 baby = k % baby_step_;
+        const u64 shift = giant * baby_step_;
+        Message diag(log_slots_);
+        for (u64 j = 0; j < dim; ++j)
+            diag[j] = entry((j + dim - shift) % dim, k);
+        diagonals_[giant].emplace_back(baby, encoder.encode(diag, level_));
+        baby_indices.insert(baby);
+    }
+    baby_indices_.assign(baby_indices.begin(), baby_indices.end());
+}
+
+std::vector<u64> LinearTransform::getRotationIndices() const {
+    std::set<u64> indices;
+    for (u64 baby : baby_indices_)
+        if (baby != 0)
+            indices.insert(baby);
+    for (const auto &diag : diagonals_)
+        if (diag.first != 0)
+            indices.insert(diag.first * baby_step_);
+    return {indices.begin(), indices.end()};
+}
+
+u64 LinearTransform::getNumDiagonals() const {
+    u64 num_diagonals = 0;
+    for (const auto &diag : diagonals_)
+        num_diagonals += diag.second.size();
+    return num_diagonals;
+}
+
+void LinearTransform::apply(const Ciphertext &ctxt,
+                            Ciphertext &ctxt_out) const {
+    if (ctxt.getLogSlots() != log_slots_)
+        throw RuntimeException("[LinearTransform::apply] The number of slots "
+                               "of the ciphertext differs from the size of "
+                               "the matrix");
+    if (ctxt.getRescaleCounter() != 0)
+        throw RuntimeException("[LinearTransform::apply] Rescale counter of "
+                               "the ciphertext should be zero");
+
+    const Context &context = eval_.getContext();
+    const Ciphertext *input = &ctxt;
+    Ciphertext leveled(context);
+    if (ctxt.getLevel() > level_) {
+        eval_.levelDown(ctxt, level_, leveled);
+        input = &leveled;
+    }
+
+    std::vector<Ciphertext> baby_rotated;
+    eval_.leftRotate(*input, baby_indices_, baby_rotated);
+    const auto rotated = [&](u64 baby) {
+        const auto pos = std::lower_bound(baby_indices_.begin(),
+                                          baby_indices_.end(), baby) -
+                         baby_indices_.begin();
+        return &baby_rotated[pos];
+    };
+
+    Ciphertext result(context);
+    Ciphertext partial(context);
+    bool is_first = true;
+    for (const auto &[giant, terms] : diagonals_) {
+        std::vector<const Ciphertext *> ctxts;
+        std::vector<const Plaintext *> ptxts;
+        ctxts.reserve(terms.size());
+        ptxts.reserve(terms.size());
+        for (const auto &[baby, ptxt] : terms) {
+            ctxts.push_back(rotated(baby));
+            ptxts.push_back(&ptxt);
+        }
+        detail::innerProduct(eval_, ctxts, ptxts, partial);
+        if (giant != 0)
+            eval_.leftRotate(partial, giant * baby_step_, partial);
+        if (is_first) {
+            std::swap(result, partial);
+            is_first = false;
+        } else {
+            eval_.add(result, partial, result);
+        }
+    }
+    ctxt_out = std::move(result);
+}
+
+} // namespace HEaaN
@@ -0,0 +1,80 @@
+////////////////////////////////////////////////////////////////////////////////
+//                                                                            //
+// Copyright (C) 2021-2023 Crypto Lab Inc.                                    //
+//                                                                            //
+// - This file is part of HEaaN homomorphic encryption library.               //
+// - HEaaN cannot be copied and/or distributed without the express permission //
+//  of Crypto Lab Inc.                                                        //
+//                                                                            //
+////////////////////////////////////////////////////////////////////////////////
+
+#include "MappedFile.hpp"
+
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include "HEaaN/Exception.hpp"
+
+namespace HEaaN::detail {
+
+MappedFile::MappedFile(const std::string &path) {
+    const int fd = ::open(path.c_str(), O_RDONLY | O_CLOEXEC);
+    if (fd < 0)
+        throw RuntimeException("[MappedFile] Cannot open " + path);
+    struct stat status;
+    if (::fstat(fd, &status) != 0) {
+        ::close(fd);
+        throw RuntimeException("[MappedFile] Cannot stat " + path);
+    }
+    size_ = static_cast<std::size_t>(status.st_size);
+    if (size_ != 0) {
+        void *addr = ::mmap(nullptr, size_, PROT_READ, MAP_SHARED, fd, 0);
+        if (addr == MAP_FAILED) {
+            ::close(fd);
+            throw RuntimeException("[MappedFile] Cannot map " + path);
+        }
+        // Files are read front to back once; start the readahead now.
+        ::madvise(addr, size_, MADV_SEQUENTIAL);
+        ::madvise(addr, size_, MADV_WILLNEED);
+        data_ = static_cast<const char *>(addr);
+    }
+    // The mapping stays valid after the descriptor is closed.
+    ::close(fd);
+}
+
+MappedFile::~MappedFile() {
+    if (data_ != nullptr)
+        ::munmap(const_cast<char *>(data_), size_);
+}
+
+MemoryStreamBuf::MemoryStreamBuf(const char *data, std::size_t size) {
+    // The get area is only read from.
+    char *begin = const_cast<char *>(data);
+    setg(begin, begin, begin + size);
+}
+
+MemoryStreamBuf::pos_type
+MemoryStreamBuf::seekoff(off_type off, std::ios_base::seekdir dir,
+                         std::ios_base::openmode which) {
+    if (!(which & std::ios_base::in))
+        return pos_type(off_type(-1));
+    off_type base = 0;
+    if (dir == std::ios_base::cur)
+        base = gptr() - eback();
+    else if (dir == std::ios_base::end)
+        base = egptr() - eback();
+    const off_type target = base + off;
+    if (target < 0 || target > egptr() - eback())
+        return pos_type(off_type(-1));
+    setg(eback(), eback() + target, egptr());
+    return pos_type(target);
+}
+
+MemoryStreamBuf::pos_type
+MemoryStreamBuf::seekpos(pos_type pos, std::ios_base::openmode which) {
+    return seekoff(off_type(pos), std::ios_base::beg, which);
+}
+
+} // namespace HEaaN::detail
@@ -0,0 +1,53 @@
+////////////////////////////////////////////////////////////////////////////////
+//                                                                            //
+// Copyright (C) 2021-2023 Crypto Lab Inc.                                    //
+//                                                                            //
+// - This file is part of HEaaN homomorphic encryption library.               //
+// - HEaaN cannot be copied and/or distributed without the express permission //
+//  of Crypto Lab Inc.                                                        //
+//                                                                            //
+////////////////////////////////////////////////////////////////////////////////
+
+#pragma once
+
+#include <cstddef>
+#include <streambuf>
+#include <string>
+
+namespace HEaaN::detail {
+
+///@brief Read-only memory mapping of a whole file
+///@details The pages are those of the page cache, shared with every other
+/// process mapping or reading the same file, and are faulted in as they are
+/// touched.
+class MappedFile {
+public:
+    ///@throws RuntimeException if the file cannot be opened or mapped.
+    explicit MappedFile(const std::string &path);
+    ~MappedFile();
+
+    MappedFile(const MappedFile &) = delete;
+    MappedFile &operator=(const MappedFile &) = delete;
+
+    const char *data() const { return data_; }
+    std::size_t size() const { return size_; }
+
+private:
+    const char *data_ = nullptr;
+    std::size_t size_ = 0;
+};
+
+///@brief Input stream buffer reading a memory region in place
+///@details Reads through an std::istream on top of it copy straight from the
+/// region into the destination, without an intermediate buffer.
+class MemoryStreamBuf : public std::streambuf {
+public:
+    MemoryStreamBuf(const char *data, std::size_t size);
+
+protected:
+    pos_type seekoff(off_type off, std::ios_base::seekdir dir,
+                     std::ios_base::openmode which) override;
+    pos_type seekpos(pos_type pos, std::ios_base::openmode which) override;
+};
+
+} // namespace HEaaN::detail
@@ -0,0 +1,321 @@
+////////////////////////////////////////////////////////////////////////////////
+//                                                                            //
+// Copyright (C) 2021-2023 Crypto Lab Inc.                                    //
+//                                                                            //
+// - This file is part of HEaaN homomorphic encryption library.               //
+// - HEaaN cannot be copied and/or distributed without the express permission //
+//  of Crypto Lab Inc.                                                        //
+//                                                                            //
+////////////////////////////////////////////////////////////////////////////////
+
+#include "HEaaN/MathEvaluator.hpp"
+
+#include <algorithm>
+#include <cmath>
+#include <functional>
+#include <limits>
+
+#include "HEaaN/Ciphertext.hpp"
+#include "HEaaN/Exception.hpp"
+
+namespace HEaaN {
+
+namespace {
+
+constexpr u64 MAX_LOG_ERROR = 40;
+constexpr u64 MAX_POLY_DEPTH = 6;
+constexpr u64 MAX_ITERATIONS = 16;
+constexpr u64 NUM_SAMPLES = 4096;
+constexpr Real MAX_EXTENDED_VALUE = 1 << 20;
+
+using RealFunc = std::function<Real(Real)>;
+
+// Map from [lo, hi] to [-1, 1]
+Real toChebyshevDomain(Real x, Real lo, Real hi) {
+    return (2 * x - (hi + lo)) / (hi - lo);
+}
+
+// Coefficients of the Chebyshev interpolant of func on [lo, hi] at the
+// degree + 1 Chebyshev nodes
+std::vector<Real> chebyshevFit(const RealFunc &func, Real lo, Real hi,
+                               u64 degree) {
+    const u64 num_nodes = degree + 1;
+    std::vector<Real> values(num_nodes);
+    std::vector<Real> angles(num_nodes);
+    for (u64 i = 0; i < num_nodes; ++i) {
+        angles[i] = REAL_PI * (static_cast<Real>(i) + 0.5) / num_nodes;
+        values[i] = func((hi - lo) / 2 * std::cos(angles[i]) + (hi + lo) / 2);
+    }
+    std::vector<Real> coeffs(num_nodes, REAL_ZERO);
+    for (u64 k = 0; k < num_nodes; ++k) {
+        for (u64 i = 0; i < num_nodes; ++i)
+            coeffs[k] += values[i] * std::cos(k * angles[i]);
+        coeffs[k] *= 2.0 / num_nodes;
+    }
+    coeffs[0] /= 2;
+    return coeffs;
+}
+
+// Σ c_k T_k(t) by the Clenshaw recurrence
+Real evaluateChebyshev(const std::vector<Real> &coeffs, Real t) {
+    Real b1 = 0;
+    Real b2 = 0;
+    for (u64 k = coeffs.size(); k-- > 1;) {
+        const Real b0 = 2 * t * b1 - b2 + coeffs[k];
+        b2 = b1;
+        b1 = b0;
+    }
+    return t * b1 - b2 + coeffs[0];
+}
+
+// Largest |error(x, p(x))| over log-spaced samples of [lo, hi]
+Real maxInitialError(const std::vector<Real> &coeffs, Real lo, Real hi,
+                     const std::function<Real(Real, Real)> &error) {
+    Real max_error = 0;
+    for (u64 s = 0; s <= NUM_SAMPLES; ++s) {
+        const Real x =
+            lo * std::pow(hi / lo, static_cast<Real>(s) / NUM_SAMPLES);
+        const Real approx =
+            evaluateChebyshev(coeffs, toChebyshevDomain(x, lo, hi));
+        max_error = std::max(max_error, std::abs(error(x, approx)));
+    }
+    return max_error;
+}
+
+// Number of iterations of the error recurrence next taking the initial
+// error below target, or MAX_ITERATIONS + 1 if it does not converge.
+u64 countIterations(Real error, Real target,
+                    const std::function<Real(Real)> &next) {
+    u64 num_iters = 0;
+    while (error > target) {
+        const Real next_error = next(error);
+        if (num_iters == MAX_ITERATIONS || next_error >= error)
+            return MAX_ITERATIONS + 1;
+        error = next_error;
+        ++num_iters;
+    }
+    return num_iters;
+}
+
+} // namespace
+
+MathEvaluator::MathEvaluator(const HomEvaluator &eval,
+                             const Bootstrapper &btp, const MathConfig &config)
+    : eval_{eval}, btp_{btp}, poly_eval_{eval}, config_{config} {
+    const Real lo = config.min_value;
+    const Real hi = config.max_value;
+    if (!(lo > 0) || !(lo < hi))
+        throw RuntimeException("[MathEvaluator] The range should be a "
+                               "nonempty interval of positive numbers");
+    if (hi > MAX_EXTENDED_VALUE || 1 / lo > MAX_EXTENDED_VALUE)
+        throw RuntimeException("[MathEvaluator] The range exceeds that of "
+                               "bootstrapExtended");
+    if (config.log_error == 0 || config.log_error > MAX_LOG_ERROR)
+        throw RuntimeException("[MathEvaluator] log_error should be between "
+                               "1 and 40");
+    const Real target = std::ldexp(REAL_ONE, -static_cast<int>(config.log_error));
+
+    // For each depth of the initial approximation, the iterations needed
+    // afterwards; keep the plan with the smallest total depth, and the fewest
+    // multiplications among those.
+    const auto plan = [&](const RealFunc &func,
+                          const std::function<Real(Real, Real)> &error,
+                          const std::function<Real(Real)> &next,
+                          u64 depth_per_iter, u64 mults_per_iter) {
+        Approximation best{{}, MAX_ITERATIONS + 1};
+        u64 best_depth = std::numeric_limits<u64>::max();
+        u64 best_mults = std::numeric_limits<u64>::max();
+        for (u64 j = 1; j <= MAX_POLY_DEPTH; ++j) {
+            const u64 degree = (U64ONE << j) - 1;
+            auto coeffs = chebyshevFit(func, lo, hi, degree);
+            const u64 num_iters = countIterations(
+                maxInitialError(coeffs, lo, hi, error), target, next);
+            if (num_iters > MAX_ITERATIONS)
+                continue;
+            const u64 depth = j + num_iters * depth_per_iter;
+            const u64 mults = PolynomialEvaluator::getNumNonScalarMults(
+                                  degree, PolynomialBasis::CHEBYSHEV) +
+                              num_iters * mults_per_iter;
+            if (depth < best_depth ||
+                (depth == best_depth && mults < best_mults)) {
+                best = Approximation{std::move(coeffs), num_iters};
+                best_depth = depth;
+                best_mults = mults;
+            }
+        }
+        if (best.num_iters > MAX_ITERATIONS)
+            throw RuntimeException("[MathEvaluator] Could not meet the "
+                                   "precision on the range");
+        return best;
+    };
+
+    // y ~ 1/x with e = 1 - x y, and e <- e^2 per iteration
+    inverse_ = plan([](Real x) { return 1 / x; },
+                    [](Real x, Real y) { return 1 - x * y; },
+                    [](Real e) { return e * e; }, 1, 2);
+    // h ~ 1/(2 sqrt(x)) with r = 1/2 - x h^2 * 2, and r <- 3r^2/2 + r^3
+    inv_sqrt_ = plan([](Real x) { return 1 / (2 * std::sqrt(x)); },
+                     [](Real x, Real h) { return 0.5 - 2 * x * h * h; },
+                     [](Real r) { return 1.5 * r * r + r * r * r; }, 2, 3);
+}
+
+u64 MathEvaluator::getInverseDepth() const {
+    // Map to [-1, 1], the approximation, e = 1 - x y, then the iterations
+    return 1 + PolynomialEvaluator::getDepth(inverse_.coeffs.size() - 1) +
+           (inverse_.num_iters == 0 ? 0 : 1 + inverse_.num_iters);
+}
+
+u64 MathEvaluator::getSqrtDepth() const {
+    // Map to [-1, 1], the approximation, g = 2 x h, then the iterations
+    return 1 + PolynomialEvaluator::getDepth(inv_sqrt_.coeffs.size() - 1) +
+           1 + 2 * inv_sqrt_.num_iters;
+}
+
+void MathEvaluator::inverse(const Ciphertext &ctxt,
+                            Ciphertext &ctxt_out) const {
+    if (ctxt.getRescaleCounter() != 0)
+        throw RuntimeException("[MathEvaluator::inverse] Rescale counter of "
+                               "the ciphertext should be zero");
+    const Context &context = eval_.getContext();
+    Ciphertext x(context);
+    prepareInput(ctxt, getInverseDepth(), x);
+
+    Ciphertext y(context);
+    approximate(x, inverse_, y);
+    const Real y_max = 1 / config_.min_value;
+
+    Ciphertext e(context);
+    Ciphertext tmp(context);
+    const auto update_error = [&]() {
+        eval_.mult(x, y, e);
+        eval_.negate(e, e);
+        eval_.add(e, Complex(REAL_ONE), e);
+    };
+    if (inverse_.num_iters > 0)
+        update_error();
+    for (u64 i = 0; i < inverse_.num_iters; ++i) {
+        const u64 remaining = inverse_.num_iters - i;
+        const u64 level = std::min(y.getLevel(), e.getLevel());
+        if (level < remaining && level < 1 + minLevelForBootstrap(y_max)) {
+            bootstrap(y, y_max, tmp);
+            std::swap(y, tmp);
+            update_error();
+            if (std::min(y.getLevel(), e.getLevel()) <= level)
+                throw RuntimeException("[MathEvaluator::inverse] The level "
+                                       "after bootstrap is too low");
+        }
+        // y <- y (1 + e), e <- e^2
+        eval_.add(e, Complex(REAL_ONE), tmp);
+        eval_.mult(y, tmp, y);
+        if (i + 1 < inverse_.num_iters)
+            eval_.square(e, e);
+    }
+    ctxt_out = std::move(y);
+}
+
+void MathEvaluator::sqrt(const Ciphertext &ctxt, Ciphertext &ctxt_out) const {
+    if (ctxt.getRescaleCounter() != 0)
+        throw RuntimeException("[MathEvaluator::sqrt] Rescale counter of the "
+                               "ciphertext should be zero");
+    sqrtIterations(ctxt, true, ctxt_out);
+}
+
+void MathEvaluator::invSqrt(const Ciphertext &ctxt,
+                            Ciphertext &ctxt_out) const {
+    if (ctxt.getRescaleCounter() != 0)
+        throw RuntimeException("[MathEvaluator::invSqrt] Rescale counter of "
+                               "the ciphertext should be zero");
+    sqrtIterations(ctxt, false, ctxt_out);
+}
+
+void MathEvaluator::sqrtIterations(const Ciphertext &ctxt, bool want_sqrt,
+                                   Ciphertext &ctxt_out) const {
+    const Context &context = eval_.getContext();
+    Ciphertext x(context);
+    prepareInput(ctxt, getSqrtDepth(), x);
+
+    // h ~ 1/(2 sqrt(x)) and g = 2 x h ~ sqrt(x)
+    Ciphertext h(context);
+    approximate(x, inv_sqrt_, h);
+    const Real h_max = 1 / (2 * std::sqrt(config_.min_value));
+
+    Ciphertext g(context);
+    Ciphertext r(context);
+    const auto update_root = [&]() {
+        eval_.mult(x, h, g);
+        eval_.add(g, g, g);
+    };
+    const u64 num_iters = inv_sqrt_.num_iters;
+    if (want_sqrt || num_iters > 0)
+        update_root();
+    for (u64 i = 0; i < num_iters; ++i) {
+        const u64 remaining = 2 * (num_iters - i);
+        const u64 level = std::min(g.getLevel(), h.getLevel());
+        if (level < remaining && level < 2 + minLevelForBootstrap(h_max)) {
+            bootstrap(h, h_max, r);
+            std::swap(h, r);
+            update_root();
+            if (std::min(g.getLevel(), h.getLevel()) <= level)
+                throw RuntimeException("[MathEvaluator] The level after "
+                                       "bootstrap is too low");
+        }
+        // r = 1/2 - g h, then g <- g (1 + r) and h <- h (1 + r), where r
+        // holds 1 + r = 3/2 - g h
+        eval_.mult(g, h, r);
+        eval_.negate(r, r);
+        eval_.add(r, Complex(1.5), r);
+        const bool is_last = i + 1 == num_iters;
+        if (!is_last || want_sqrt)
+            eval_.mult(g, r, g);
+        if (!is_last || !want_sqrt)
+            eval_.mult(h, r, h);
+    }
+
+    if (want_sqrt) {
+        ctxt_out = std::move(g);
+    } else {
+        eval_.add(h, h, h);
+        ctxt_out = std::move(h);
+    }
+}
+
+u64 MathEvaluator::minLevelForBootstrap(Real max_abs) const {
+    // bootstrapExtended needs one more level than bootstrap
+    return btp_.getMinLevelForBootstrap() + (max_abs > REAL_ONE ? 1 : 0);
+}
+
+void MathEvaluator::bootstrap(const Ciphertext &ctxt, Real max_abs,
+                              Ciphertext &ctxt_out) const {
+    if (ctxt.getLevel() < minLevelForBootstrap(max_abs))
+        throw RuntimeException("[MathEvaluator] The level of the ciphertext "
+                               "is too low to bootstrap");
+    if (max_abs > REAL_ONE)
+        btp_.bootstrapExtended(ctxt, ctxt_out);
+    else
+        btp_.bootstrap(ctxt, ctxt_out);
+}
+
+void MathEvaluator::prepareInput(const Ciphertext &ctxt, u64 depth,
+                                 Ciphertext &ctxt_out) const {
+    // Bootstrapping the input once keeps it high enough for the error terms
+    // recomputed after any later bootstrap.
+    if (ctxt.getLevel() < depth &&
+        ctxt.getLevel() < btp_.getLevelAfterFullSlotBootstrap())
+        bootstrap(ctxt, config_.max_value, ctxt_out);
+    else
+        ctxt_out = ctxt;
+}
+
+void MathEvaluator::approximate(const Ciphertext &ctxt,
+                                const Approximation &approx,
+                                Ciphertext &ctxt_out) const {
+    const Real lo = config_.min_value;
+    const Real hi = config_.max_value;
+    Ciphertext t(eval_.getContext());
+    eval_.mult(ctxt, Complex(2 / (hi - lo)), t);
+    eval_.sub(t, Complex((hi + lo) / (hi - lo)), t);
+    poly_eval_.evaluate(t, approx.coeffs, PolynomialBasis::CHEBYSHEV,
+                        ctxt_out);
+}
+
+} // namespace HEaaN
@@ -0,0 +1,86 @@
+////////////////////////////////////////////////////////////////////////////////
+//                                                                            //
+// Copyright (C) 2021-2023 Crypto Lab Inc.                                    //
+//                                                                            //
+// - This file is part of HEaaN homomorphic encryption library.               //
+// - HEaaN cannot be copied and/or distributed without the express permission //
+//  of Crypto Lab Inc.                                                        //
+//                                                                            //
+////////////////////////////////////////////////////////////////////////////////
+
+#pragma once
+
+#include "HEaaN/Integers.hpp"
+
+namespace HEaaN::detail {
+
+using u128 = unsigned __int128;
+
+///@brief Arithmetic modulo a prime below 2^62 with precomputed Shoup
+/// companion words instead of divisions
+class Modulus {
+public:
+    explicit Modulus(u64 prime) : prime_{prime} {
+        const u128 two_64 = static_cast<u128>(1) << 64;
+        two_64_ = static_cast<u64>(two_64 % prime);
+        two_64_shoup_ = shoup(two_64_);
+        one_shoup_ = static_cast<u64>(two_64 / prime);
+    }
+
+    u64 getPrime() const { return prime_; }
+
+    ///@brief floor(w * 2^64 / prime), the companion word of w < prime
+    u64 shoup(u64 w) const {
+        return static_cast<u64>((static_cast<u128>(w) << 64) / prime_);
+    }
+
+    ///@brief a * w mod prime, where w_shoup = shoup(w)
+    u64 mulShoup(u64 a, u64 w, u64 w_shoup) const {
+        const u64 quot =
+            static_cast<u64>((static_cast<u128>(a) * w_shoup) >> 64);
+        const u64 rem = a * w - quot * prime_;
+        return rem >= prime_ ? rem - prime_ : rem;
+    }
+
+    ///@brief a * b mod prime
+    u64 mul(u64 a, u64 b) const {
+        return reduce(static_cast<u128>(a) * b);
+    }
+
+    ///@brief base^exp mod prime
+    u64 pow(u64 base, u64 exp) const {
+        u64 result = 1;
+        for (; exp != 0; exp >>= 1) {
+            if (exp & 1)
+                result = mul(result, base);
+            base = mul(base, base);
+        }
+        return result;
+    }
+
+    ///@brief value mod prime
+    u64 reduce(u128 value) const {
+        const u64 high = mulShoup(static_cast<u64>(value >> 64), two_64_,
+                                  two_64_shoup_);
+        const u64 low = mulShoup(static_cast<u64>(value), 1, one_shoup_);
+        const u64 sum = high + low;
+        return sum >= prime_ ? sum - prime_ : sum;
+    }
+
+    ///@brief Largest number of products of residues which can be added to a
+    /// reduced value in a u128 accumulator without overflow
+    u64 lazyReductionInterval() const {
+        const int bits = 64 - __builtin_clzll(prime_);
+        const int spare_bits = 128 - 2 * bits;
+        return (spare_bits >= 62 ? (U64ONE << 62) : (U64ONE << spare_bits)) -
+               1;
+    }
+
+private:
+    u64 prime_;
+    u64 two_64_;
+    u64 two_64_shoup_;
+    u64 one_shoup_;
+};
+
+} // namespace HEaaN::detail
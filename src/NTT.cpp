@@ -0,0 +1,96 @@
+////////////////////////////////////////////////////////////////////////////////
+//                                                                            //
+// Copyright (C) 2021-2023 Crypto Lab Inc.                                    //
+//                                                                            //
+// - This file is part of HEaaN homomorphic encryption library.               //
+// - HEaaN cannot be copied and/or distributed without the express permission //
+//  of Crypto Lab Inc.                                                        //
+//                                                                            //
+////////////////////////////////////////////////////////////////////////////////
+
+#include "NTT.hpp"
+
+#include <algorithm>
+
+#include "HEaaN/Exception.hpp"
+
+namespace HEaaN::detail {
+
+namespace {
+
+u64 bitReverse(u64 value, u64 num_bits) {
+    u64 result = 0;
+    for (u64 b = 0; b < num_bits; ++b)
+        result |= ((value >> b) & 1) << (num_bits - 1 - b);
+    return result;
+}
+
+// Smallest primitive two_degree-th root of unity modulo the prime
+u64 findMinimalRoot(const Modulus &modulus, u64 two_degree) {
+    const u64 prime = modulus.getPrime();
+    u64 root = 0;
+    for (u64 g = 2; g < prime; ++g) {
+        const u64 candidate = modulus.pow(g, (prime - 1) / two_degree);
+        if (modulus.pow(candidate, two_degree / 2) == prime - 1) {
+            root = candidate;
+            break;
+        }
+    }
+    // The primitive roots are the odd powers of any one of them.
+    const u64 square = modulus.mul(root, root);
+    u64 minimal = root;
+    for (u64 k = 1, power = root; k < two_degree; k += 2) {
+        minimal = std::min(minimal, power);
+        power = modulus.mul(power, square);
+    }
+    return minimal;
+}
+
+} // namespace
+
+NTT::NTT(u64 prime, u64 degree)
+    : modulus_{prime}, degree_{degree}, twiddles_(degree),
+      twiddles_shoup_(degree) {
+    if ((prime - 1) % (2 * degree) != 0)
+        throw RuntimeException("[NTT] The prime does not support the "
+                               "negacyclic transform of this dimension");
+
+    const u64 log_degree = static_cast<u64>(__builtin_ctzll(degree));
+    const u64 psi = findMinimalRoot(modulus_, 2 * degree);
+    for (u64 k = 0, power = 1; k < degree; ++k) {
+        const u64 index = bitReverse(k, log_degree);
+        twiddles_[index] = power;
+        twiddles_shoup_[index] = modulus_.shoup(power);
+        power = modulus_.mul(power, psi);
+    }
+}
+
+void NTT::forward(u64 *data) const {
+    const u64 prime = modulus_.getPrime();
+    for (u64 m = 1, t = degree_; m < degree_; m *= 2) {
+        t /= 2;
+        for (u64 i = 0; i < m; ++i) {
+            const u64 w = twiddles_[m + i];
+            const u64 w_shoup = twiddles_shoup_[m + i];
+            u64 *lo = data + 2 * i * t;
+            u64 *hi = lo + t;
+            for (u64 j = 0; j < t; ++j) {
+                const u64 u = lo[j];
+                const u64 v = modulus_.mulShoup(hi[j], w, w_shoup);
+                const u64 sum = u + v;
+                lo[j] = sum >= prime ? sum - prime : sum;
+                hi[j] = u >= v ? u - v : u + prime - v;
+            }
+        }
+    }
+}
+
+void NTT::forward(const int *coeffs, u64 *out) const {
+    const u64 prime = modulus_.getPrime();
+    for (u64 i = 0; i < degree_; ++i)
+        out[i] = coeffs[i] < 0 ? prime - static_cast<u64>(-coeffs[i])
+                               : static_cast<u64>(coeffs[i]);
+    forward(out);
+}
+
+} // namespace HEaaN::detail
@@ -0,0 +1,49 @@
+////////////////////////////////////////////////////////////////////////////////
+//                                                                            //
+// Copyright (C) 2021-2023 Crypto Lab Inc.                                    //
+//                                                                            //
+// - This file is part of HEaaN homomorphic encryption library.               //
+// - HEaaN cannot be copied and/or distributed without the express permission //
+//  of Crypto Lab Inc.                                                        //
+//                                                                            //
+////////////////////////////////////////////////////////////////////////////////
+
+#pragma once
+
+#include <vector>
+
+#include "HEaaN/Integers.hpp"
+#include "Modulus.hpp"
+
+namespace HEaaN::detail {
+
+///@brief Forward negacyclic number theoretic transform modulo one prime
+///@details out[i] = p(ψ^(2 * bitrev(i) + 1)) for the smallest primitive
+/// 2N-th root of unity ψ, which is the evaluation form the library keeps
+/// ciphertexts and plaintexts in. Only the forward direction is needed to
+/// build ciphertexts outside the library.
+class NTT {
+public:
+    ///@brief Precompute the twiddle factors for dimension degree
+    ///@throws RuntimeException if prime is not 1 modulo 2 * degree.
+    NTT(u64 prime, u64 degree);
+
+    const Modulus &getModulus() const { return modulus_; }
+
+    ///@brief Transform degree residues in place
+    ///@details Inputs are expected to be reduced, as are the outputs.
+    void forward(u64 *data) const;
+
+    ///@brief Transform degree small signed coefficients, e.g. those of a
+    /// secret key, into out
+    void forward(const int *coeffs, u64 *out) const;
+
+private:
+    Modulus modulus_;
+    u64 degree_;
+    ///@brief ψ^bitrev(k) for 0 <= k < degree
+    std::vector<u64> twiddles_;
+    std::vector<u64> twiddles_shoup_;
+};
+
+} // namespace HEaaN::detail
@@ -0,0 +1,72 @@
+////////////////////////////////////////////////////////////////////////////////
+//                                                                            //
+// Copyright (C) 2021-2023 Crypto Lab Inc.                                    //
+//                                                                            //
+// - This file is part of HEaaN homomorphic encryption library.               //
+// - HEaaN cannot be copied and/or distributed without the express permission //
+//  of Crypto Lab Inc.                                                        //
+//                                                                            //
+////////////////////////////////////////////////////////////////////////////////
+
+#pragma once
+
+#include <exception>
+
+#include <omp.h>
+
+#include "HEaaN/Integers.hpp"
+
+namespace HEaaN {
+
+///@brief Run func(i) for every i in [0, num_items) across OpenMP threads.
+///@details Each item is handed to one thread, so the parallel regions opened
+/// by HomEvaluator inside func run nested (i.e. serially) on that thread.
+/// With fewer items than threads, the items run one after another on the
+/// calling thread instead, which keeps those inner regions parallel rather
+/// than leaving threads idle. The first exception thrown by any item is
+/// rethrown on the calling thread; run serially, the remaining items are
+/// skipped, otherwise it is rethrown once all the items have finished.
+template <class Func> void parallelFor(u64 num_items, Func &&func) {
+    if (num_items < 2 ||
+        num_items < static_cast<u64>(omp_get_max_threads())) {
+        for (u64 i = 0; i < num_items; ++i)
+            func(i);
+        return;
+    }
+
+    std::exception_ptr error;
+#pragma omp parallel for schedule(dynamic)
+    for (i64 i = 0; i < static_cast<i64>(num_items); ++i) {
+        try {
+            func(static_cast<u64>(i));
+        } catch (...) {
+#pragma omp critical(heaan_parallel_for_error)
+            if (!error)
+                error = std::current_exception();
+        }
+    }
+    if (error)
+        std::rethrow_exception(error);
+}
+
+///@brief Run func(t) once on each of num_threads OpenMP threads, t being the
+/// index of the thread.
+///@details Exceptions are handled as in parallelFor.
+template <class Func> void parallelForEachThread(u64 num_threads, Func &&func) {
+    std::exception_ptr error;
+#pragma omp parallel for num_threads(static_cast<int>(num_threads))            \
+    schedule(static, 1)
+    for (i64 t = 0; t < static_cast<i64>(num_threads); ++t) {
+        try {
+            func(static_cast<u64>(t));
+        } catch (...) {
+#pragma omp critical(heaan_parallel_for_error)
+            if (!error)
+                error = std::current_exception();
+        }
+    }
+    if (error)
+        std::rethrow_exception(error);
+}
+
+} // namespace HEaaN
@@ -0,0 +1,304 @@
+////////////////////////////////////////////////////////////////////////////////
+//                                                                            //
+// Copyright (C) 2021-2023 Crypto Lab Inc.                                    //
+//                                                                            //
+// - This file is part of HEaaN homomorphic encryption library.               //
+// - HEaaN cannot be copied and/or distributed without the express permission //
+//  of Crypto Lab Inc.                                                        //
+//                                                                            //
+////////////////////////////////////////////////////////////////////////////////
+
+#include "HEaaN/PolynomialEvaluator.hpp"
+#include <algorithm>
+#include <limits>
+#include <map>
+#include <set>
+#include <utility>
+
+#include "HEaaN/Ciphertext.hpp"
+#include "HEaaN/Exception.hpp"
+#include "PowerIndex.hpp"
+
+namespace HEaaN {
+
+namespace {
+
+constexpr u64 INFEASIBLE = std::numeric_limits<u64>::max();
+constexpr u64 LEAF = std::numeric_limits<u64>::max();
+
+using detail::ceilLog2;
+using detail::powerDependencies;
+
+// Degree of the polynomial ignoring trailing zero coefficients
+u64 degreeOf(const std::vector<Real> &coeffs) {
+    u64 size = coeffs.size();
+    while (size > 1 && coeffs[size - 1] == REAL_ZERO)
+        --size;
+    return size == 0 ? 0 : size - 1;
+}
+
+// Depth of a leaf of given degree: the deepest power plus one scalar
+// multiplication.
+u64 leafDepth(u64 degree) { return degree == 0 ? 0 : ceilLog2(degree) + 1; }
+
+//
+// Evaluation plan for a given baby-step bound k: a node of some degree and
+// depth budget is either a leaf (degree < k) whose terms are multiplied by
+// scalars, or a split p = q * x^(2^j) + r. Among the feasible plans the one
+// with the fewest non-scalar multiplications is kept.
+//
+class Plan {
+public:
+    Plan(u64 baby_bound, PolynomialBasis basis)
+        : baby_bound_{baby_bound}, basis_{basis} {}
+
+    // Non-scalar multiplications needed to recombine the leaves, or
+    // INFEASIBLE
+    u64 cost(u64 degree, u64 budget) { return solve(degree, budget).first; }
+
+    // LEAF, or the exponent j of the split p = q * x^(2^j) + r
+    u64 choice(u64 degree, u64 budget) {
+        return solve(degree, budget).second;
+    }
+
+    // Total non-scalar multiplications including the powers
+    u64 totalCost(u64 degree, u64 budget) {
+        const u64 tree_cost = cost(degree, budget);
+        if (tree_cost == INFEASIBLE)
+            return INFEASIBLE;
+        std::set<u64> powers;
+        collectPowers(degree, budget, powers);
+        std::vector<u64> stack(powers.begin(), powers.end());
+        while (!stack.empty()) {
+            const u64 idx = stack.back();
+            stack.pop_back();
+            for (u64 dep : powerDependencies(idx, basis_))
+                if (powers.insert(dep).second)
+                    stack.push_back(dep);
+        }
+        powers.erase(1);
+        return tree_cost + powers.size();
+    }
+
+private:
+    u64 baby_bound_;
+    PolynomialBasis basis_;
+    std::map<std::pair<u64, u64>, std::pair<u64, u64>> memo_;
+
+    std::pair<u64, u64> solve(u64 degree, u64 budget) {
+        const auto key = std::make_pair(degree, budget);
+        if (auto it = memo_.find(key); it != memo_.end())
+            return it->second;
+
+        std::pair<u64, u64> best{INFEASIBLE, LEAF};
+        if (degree < baby_bound_ && leafDepth(degree) <= budget)
+            best = {0, LEAF};
+        for (u64 j = 0; (U64ONE << j) <= degree && j + 1 <= budget; ++j) {
+            const u64 giant = U64ONE << j;
+            const u64 quot_cost = cost(degree - giant, budget - 1);
+            const u64 rem_cost = cost(giant - 1, budget);
+            if (quot_cost == INFEASIBLE || rem_cost == INFEASIBLE)
+                continue;
+            // A constant quotient only needs a scalar multiplication.
+            const u64 split_cost =
+                (degree == giant ? 0 : 1) + quot_cost + rem_cost;
+            if (split_cost < best.first)
+                best = {split_cost, j};
+        }
+        memo_[key] = best;
+        return best;
+    }
+
+    void collectPowers(u64 degree, u64 budget, std::set<u64> &powers) {
+        const u64 j = choice(degree, budget);
+        if (j == LEAF) {
+            for (u64 i = 1; i <= degree; ++i)
+                powers.insert(i);
+            return;
+        }
+        const u64 giant = U64ONE << j;
+        powers.insert(giant);
+        collectPowers(degree - giant, budget - 1, powers);
+        collectPowers(giant - 1, budget, powers);
+    }
+};
+
+// The plan with the fewest non-scalar multiplications among the baby-step
+// bounds 2, 4, ..., 2^depth.
+Plan choosePlan(u64 degree, PolynomialBasis basis) {
+    const u64 depth = PolynomialEvaluator::getDepth(degree);
+    Plan best{2, basis};
+    u64 best_cost = best.totalCost(degree, depth);
+    for (u64 m = 2; m <= depth; ++m) {
+        Plan candidate{U64ONE << m, basis};
+        const u64 candidate_cost = candidate.totalCost(degree, depth);
+        if (candidate_cost < best_cost) {
+            best = std::move(candidate);
+            best_cost = candidate_cost;
+        }
+    }
+    return best;
+}
+
+// p = q * x^giant + r in the monomial basis
+void divideMonomial(const std::vector<Real> &coeffs, u64 giant,
+                    std::vector<Real> &quot, std::vector<Real> &rem) {
+    rem.assign(coeffs.begin(), coeffs.begin() + giant);
+    quot.assign(coeffs.begin() + giant, coeffs.end());
+}
+
+// p = q * T_giant + r in the Chebyshev basis, using
+// T_giant * T_j = (T_(giant + j) + T_|giant - j|) / 2.
+void divideChebyshev(const std::vector<Real> &coeffs, u64 giant,
+                     std::vector<Real> &quot, std::vector<Real> &rem) {
+    std::vector<Real> work(coeffs);
+    quot.assign(work.size() - giant, REAL_ZERO);
+    for (u64 i = work.size() - 1; i > giant; --i) {
+        const Real c = work[i];
+        const u64 j = i - giant;
+        quot[j] += 2 * c;
+        work[i] = REAL_ZERO;
+        work[giant > j ? giant - j : j - giant] -= c;
+    }
+    quot[0] += work[giant];
+    rem.assign(work.begin(), work.begin() + giant);
+}
+
+class PolynomialEvaluation {
+public:
+    PolynomialEvaluation(const HomEvaluator &eval, PowerBasis &powers,
+                         u64 degree)
+        : eval_{eval}, basis_{powers.getBasis()},
+          plan_{choosePlan(degree, basis_)}, powers_{powers} {}
+
+    // Evaluate a polynomial of positive degree within the depth budget.
+    void evaluate(const std::vector<Real> &coeffs, u64 budget,
+                  Ciphertext &ctxt_out) {
+        const u64 degree = degreeOf(coeffs);
+        const u64 j = plan_.choice(degree, budget);
+        if (j == LEAF) {
+            evaluateLeaf(coeffs, degree, ctxt_out);
+            return;
+        }
+
+        const u64 giant = U64ONE << j;
+        std::vector<Real> quot;
+        std::vector<Real> rem;
+        if (basis_ == PolynomialBasis::CHEBYSHEV)
+            divideChebyshev(coeffs, giant, quot, rem);
+        else
+            divideMonomial(coeffs, giant, quot, rem);
+
+        const u64 quot_degree = degreeOf(quot);
+        const u64 rem_degree = degreeOf(rem);
+        const auto giant_power = powers_.getPower(giant);
+        if (quot_degree == 0) {
+            eval_.mult(*giant_power, Complex(quot[0]), ctxt_out);
+        } else {
+            Ciphertext quot_ctxt(eval_.getContext());
+            evaluate(quot, budget - 1, quot_ctxt);
+            eval_.mult(quot_ctxt, *giant_power, ctxt_out);
+        }
+
+        if (rem_degree == 0) {
+            if (rem[0] != REAL_ZERO)
+                eval_.add(ctxt_out, Complex(rem[0]), ctxt_out);
+        } else {
+            Ciphertext rem_ctxt(eval_.getContext());
+            evaluate(rem, budget, rem_ctxt);
+            eval_.add(ctxt_out, rem_ctxt, ctxt_out);
+        }
+    }
+
+private:
+    const HomEvaluator &eval_;
+    PolynomialBasis basis_;
+    Plan plan_;
+    PowerBasis &powers_;
+
+    // Σ c_i x^i with one scalar multiplication per term: the powers are
+    // taken at the lowest level among them, multiplied without rescaling,
+    // summed, and rescaled once.
+    void evaluateLeaf(const std::vector<Real> &coeffs, u64 degree,
+                      Ciphertext &ctxt_out) {
+        const u64 level = powers_.getInput().getLevel() -
+                          PowerBasis::getPowerDepth(degree);
+
+        Ciphertext term(eval_.getContext());
+        bool is_first = true;
+        for (u64 i = 1; i <= degree; ++i) {
+            if (coeffs[i] == REAL_ZERO)
+                continue;
+            const auto power = powers_.getPower(i, level);
+            if (is_first) {
+                eval_.multWithoutRescale(*power, Complex(coeffs[i]),
+                                         ctxt_out);
+                is_first = false;
+            } else {
+                eval_.multWithoutRescale(*power, Complex(coeffs[i]), term);
+                eval_.add(ctxt_out, term, ctxt_out);
+            }
+        }
+        eval_.rescale(ctxt_out);
+        if (coeffs[0] != REAL_ZERO)
+            eval_.add(ctxt_out, Complex(coeffs[0]), ctxt_out);
+    }
+};
+
+} // namespace
+
+PolynomialEvaluator::PolynomialEvaluator(const HomEvaluator &eval)
+    : eval_{eval} {}
+
+u64 PolynomialEvaluator::getDepth(u64 degree) { return ceilLog2(degree + 1); }
+
+u64 PolynomialEvaluator::getNumNonScalarMults(u64 degree,
+                                              PolynomialBasis basis) {
+    if (degree <= 1)
+        return 0;
+    return choosePlan(degree, basis).totalCost(degree, getDepth(degree));
+}
+
+void PolynomialEvaluator::evaluate(const Ciphertext &ctxt,
+                                   const std::vector<Real> &coeffs,
+                                   PolynomialBasis basis,
+                                   Ciphertext &ctxt_out) const {
+    if (ctxt.getRescaleCounter() != 0)
+        throw RuntimeException("[PolynomialEvaluator::evaluate] Rescale "
+                               "counter of the ciphertext should be zero");
+    PowerBasis powers(eval_, ctxt, basis);
+    evaluate(powers, coeffs, ctxt_out);
+}
+
+void PolynomialEvaluator::evaluate(PowerBasis &powers,
+                                   const std::vector<Real> &coeffs,
+                                   Ciphertext &ctxt_out) const {
+    if (coeffs.empty())
+        throw RuntimeException("[PolynomialEvaluator::evaluate] The "
+                               "coefficients are empty");
+    const Ciphertext &ctxt = powers.getInput();
+    const u64 degree = degreeOf(coeffs);
+    const u64 depth = getDepth(degree);
+    if (ctxt.getLevel() < depth)
+        throw RuntimeException("[PolynomialEvaluator::evaluate] The level of "
+                               "the ciphertext is less than the depth of the "
+                               "polynomial");
+
+    if (degree == 0) {
+        eval_.multInteger(ctxt, 0, ctxt_out);
+        eval_.add(ctxt_out, Complex(coeffs[0]), ctxt_out);
+        return;
+    }
+
+    std::vector<Real> trimmed(coeffs.begin(), coeffs.begin() + degree + 1);
+    Ciphertext result(eval_.getContext());
+    PolynomialEvaluation(eval_, powers, degree).evaluate(trimmed, depth, result);
+    // Integral coefficients are multiplied without consuming depth, so the
+    // result may end up above the planned level.
+    const u64 target_level = ctxt.getLevel() - depth;
+    if (result.getLevel() > target_level)
+        eval_.levelDown(result, target_level, result);
+    ctxt_out = std::move(result);
+}
+
+} // namespace HEaaN
@@ -0,0 +1,136 @@
+////////////////////////////////////////////////////////////////////////////////
+//                                                                            //
+// Copyright (C) 2021-2023 Crypto Lab Inc.                                    //
+//                                                                            //
+// - This file is part of HEaaN homomorphic encryption library.               //
+// - HEaaN cannot be copied and/or distributed without the express permission //
+//  of Crypto Lab Inc.                                                        //
+//                                                                            //
+////////////////////////////////////////////////////////////////////////////////
+
+#include "HEaaN/PowerBasis.hpp"
+
+#include "ContextUtil.hpp"
+#include "HEaaN/Context.hpp"
+#include "HEaaN/Exception.hpp"
+#include "PowerIndex.hpp"
+
+namespace HEaaN {
+
+namespace {
+
+u64 estimateBytes(const Context &context, const Ciphertext &ctxt) {
+    const u64 degree = detail::getDegree(context);
+    return ctxt.getSize() * (ctxt.getLevel() + 1) * degree * sizeof(u64);
+}
+
+} // namespace
+
+PowerBasis::PowerBasis(const HomEvaluator &eval, const Ciphertext &ctxt,
+                       PolynomialBasis basis, u64 memory_budget)
+    : eval_{eval}, input_{std::make_shared<const Ciphertext>(ctxt)},
+      basis_{basis}, memory_budget_{memory_budget}, memory_usage_{0} {
+    if (ctxt.getRescaleCounter() != 0)
+        throw RuntimeException("[PowerBasis] Rescale counter of the "
+                               "ciphertext should be zero");
+}
+
+u64 PowerBasis::getPowerDepth(u64 idx) { return detail::ceilLog2(idx); }
+
+std::shared_ptr<const Ciphertext> PowerBasis::getPower(u64 idx) {
+    if (idx == 0)
+        throw RuntimeException("[PowerBasis::getPower] The index should be "
+                               "positive");
+    const u64 depth = getPowerDepth(idx);
+    if (input_->getLevel() < depth)
+        throw RuntimeException("[PowerBasis::getPower] The level of the input "
+                               "is less than the depth of the power");
+    if (idx == 1)
+        return input_;
+
+    const Key key{idx, input_->getLevel() - depth};
+    if (auto cached = lookup(key))
+        return cached;
+
+    Ciphertext power(eval_.getContext());
+    if (detail::isPowerOfTwo(idx)) {
+        eval_.square(*getPower(idx / 2), power);
+        if (basis_ == PolynomialBasis::CHEBYSHEV) {
+            // T_2n = 2 T_n^2 - 1
+            eval_.add(power, power, power);
+            eval_.sub(power, Complex(REAL_ONE), power);
+        }
+    } else {
+        const u64 high = U64ONE << detail::floorLog2(idx);
+        // Hold both operands, as computing the second one may drop the first
+        // from the cache.
+        const auto high_power = getPower(high);
+        const auto low_power = getPower(idx - high);
+        eval_.mult(*high_power, *low_power, power);
+        if (basis_ == PolynomialBasis::CHEBYSHEV) {
+            // T_(m + n) = 2 T_m T_n - T_(m - n)
+            eval_.add(power, power, power);
+            eval_.sub(power, *getPower(2 * high - idx), power);
+        }
+    }
+    return insert(key, std::move(power));
+}
+
+std::shared_ptr<const Ciphertext> PowerBasis::getPower(u64 idx, u64 level) {
+    auto power = getPower(idx);
+    if (level == power->getLevel())
+        return power;
+    if (level > power->getLevel())
+        throw RuntimeException("[PowerBasis::getPower] The level is above "
+                               "that of the power");
+
+    const Key key{idx, level};
+    if (auto cached = lookup(key))
+        return cached;
+    Ciphertext leveled(eval_.getContext());
+    eval_.levelDown(*power, level, leveled);
+    return insert(key, std::move(leveled));
+}
+
+void PowerBasis::setMemoryBudget(u64 memory_budget) {
+    memory_budget_ = memory_budget;
+    evictToBudget();
+}
+
+void PowerBasis::clear() {
+    cache_.clear();
+    lru_.clear();
+    memory_usage_ = 0;
+}
+
+std::shared_ptr<const Ciphertext> PowerBasis::lookup(const Key &key) {
+    auto it = cache_.find(key);
+    if (it == cache_.end())
+        return nullptr;
+    lru_.splice(lru_.begin(), lru_, it->second.lru_pos);
+    return it->second.ctxt;
+}
+
+std::shared_ptr<const Ciphertext> PowerBasis::insert(const Key &key,
+                                                     Ciphertext &&ctxt) {
+    const u64 bytes = estimateBytes(eval_.getContext(), ctxt);
+    auto shared = std::make_shared<const Ciphertext>(std::move(ctxt));
+    lru_.push_front(key);
+    cache_[key] = Entry{shared, bytes, lru_.begin()};
+    memory_usage_ += bytes;
+    evictToBudget();
+    return shared;
+}
+
+void PowerBasis::evictToBudget() {
+    if (memory_budget_ == 0)
+        return;
+    while (memory_usage_ > memory_budget_ && !lru_.empty()) {
+        auto it = cache_.find(lru_.back());
+        memory_usage_ -= it->second.bytes;
+        cache_.erase(it);
+        lru_.pop_back();
+    }
+}
+
+} // namespace HEaaN
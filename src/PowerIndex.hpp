@@ -0,0 +1,41 @@
+////////////////////////////////////////////////////////////////////////////////
+//                                                                            //
+// Copyright (C) 2021-2023 Crypto Lab Inc.                                    //
+//                                                                            //
+// - This file is part of HEaaN homomorphic encryption library.               //
+// - HEaaN cannot be copied and/or distributed without the express permission //
+//  of Crypto Lab Inc.                                                        //
+//                                                                            //
+////////////////////////////////////////////////////////////////////////////////
+
+#pragma once
+
+#include <vector>
+
+#include "HEaaN/Integers.hpp"
+#include "HEaaN/PowerBasis.hpp"
+
+namespace HEaaN::detail {
+
+inline u64 floorLog2(u64 n) { return static_cast<u64>(63 - __builtin_clzll(n)); }
+
+inline u64 ceilLog2(u64 n) { return n <= 1 ? 0 : floorLog2(n - 1) + 1; }
+
+inline bool isPowerOfTwo(u64 n) { return n != 0 && (n & (n - 1)) == 0; }
+
+///@brief Powers from which PowerBasis computes the power of index idx
+///@details x^(2n) is the square of x^n, and x^(2^k + n) = x^(2^k) * x^n for
+/// 0 < n < 2^k. In the Chebyshev basis T_(2^k + n) = 2 T_(2^k) T_n - T_(2^k - n)
+/// also needs T_(2^k - n).
+inline std::vector<u64> powerDependencies(u64 idx, PolynomialBasis basis) {
+    if (idx <= 1)
+        return {};
+    if (isPowerOfTwo(idx))
+        return {idx / 2};
+    const u64 high = U64ONE << floorLog2(idx);
+    if (basis == PolynomialBasis::CHEBYSHEV)
+        return {high, idx - high, 2 * high - idx};
+    return {high, idx - high};
+}
+
+} // namespace HEaaN::detail
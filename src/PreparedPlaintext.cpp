@@ -0,0 +1,81 @@
+////////////////////////////////////////////////////////////////////////////////
+//                                                                            //
+// Copyright (C) 2021-2023 Crypto Lab Inc.                                    //
+//                                                                            //
+// - This file is part of HEaaN homomorphic encryption library.               //
+// - HEaaN cannot be copied and/or distributed without the express permission //
+//  of Crypto Lab Inc.                                                        //
+//                                                                            //
+////////////////////////////////////////////////////////////////////////////////
+
+#include "HEaaN/PreparedPlaintext.hpp"
+
+#include "HEaaN/Context.hpp"
+#include "HEaaN/Exception.hpp"
+
+namespace HEaaN {
+
+PreparedPlaintext::PreparedPlaintext(const HomEvaluator &eval,
+                                     const Message &msg, int r_counter)
+    : eval_{eval}, encoder_{eval.getContext()}, msg_{msg},
+      max_level_{getEncryptionLevel(eval.getContext())},
+      r_counter_{r_counter}, log_slots_{msg.getLogSlots()} {
+    if (msg.isEmpty())
+        throw RuntimeException("[PreparedPlaintext] The message is empty");
+}
+
+PreparedPlaintext::PreparedPlaintext(const HomEvaluator &eval,
+                                     const Plaintext &ptxt)
+    : eval_{eval}, encoder_{eval.getContext()},
+      ptxt_{std::make_shared<const Plaintext>(ptxt)},
+      max_level_{ptxt.getLevel()}, r_counter_{ptxt.getRescaleCounter()},
+      log_slots_{ptxt.getLogSlots()} {}
+
+std::shared_ptr<const Plaintext>
+PreparedPlaintext::getPlaintext(u64 level) const {
+    if (level > max_level_)
+        throw RuntimeException("[PreparedPlaintext::getPlaintext] The level "
+                               "exceeds the maximal level of the plaintext");
+    if (ptxt_ && level == ptxt_->getLevel())
+        return ptxt_;
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        if (auto it = levels_.find(level); it != levels_.end())
+            return it->second;
+    }
+
+    // Materialize without holding the lock so that other levels are served
+    // meanwhile. A level materialized by two threads at once is kept once.
+    auto ptxt = std::make_shared<const Plaintext>(materialize(level));
+    std::lock_guard<std::mutex> lock(mutex_);
+    return levels_.emplace(level, std::move(ptxt)).first->second;
+}
+
+u64 PreparedPlaintext::getNumMaterializedLevels() const {
+    std::lock_guard<std::mutex> lock(mutex_);
+    return levels_.size() + (ptxt_ ? 1 : 0);
+}
+
+u64 PreparedPlaintext::getMemoryUsage() const {
+    const u64 degree = U64ONE << (getLogFullSlots(eval_.getContext()) + 1);
+    std::lock_guard<std::mutex> lock(mutex_);
+    u64 bytes = 0;
+    for (const auto &entry : levels_)
+        bytes += (entry.first + 1) * degree * sizeof(u64);
+    return bytes;
+}
+
+void PreparedPlaintext::clear() {
+    std::lock_guard<std::mutex> lock(mutex_);
+    levels_.clear();
+}
+
+Plaintext PreparedPlaintext::materialize(u64 level) const {
+    if (!ptxt_)
+        return encoder_.encode(msg_, level, r_counter_);
+    Plaintext ptxt(eval_.getContext());
+    eval_.relevel(*ptxt_, level, ptxt);
+    return ptxt;
+}
+
+} // namespace HEaaN
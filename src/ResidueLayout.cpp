@@ -0,0 +1,144 @@
+////////////////////////////////////////////////////////////////////////////////
+//                                                                            //
+// Copyright (C) 2021-2023 Crypto Lab Inc.                                    //
+//                                                                            //
+// - This file is part of HEaaN homomorphic encryption library.               //
+// - HEaaN cannot be copied and/or distributed without the express permission //
+//  of Crypto Lab Inc.                                                        //
+//                                                                            //
+////////////////////////////////////////////////////////////////////////////////
+
+#include "HEaaN/ResidueLayout.hpp"
+
+#include <algorithm>
+#include <string>
+
+#include "ContextUtil.hpp"
+#include "HEaaN/Exception.hpp"
+#include "ParallelFor.hpp"
+
+namespace HEaaN {
+
+namespace {
+
+// Append the array at data to spans, merging it into the last span when the
+// two are adjacent in memory
+template <class T>
+void appendResidues(std::vector<Span<T>> &spans, T *data, u64 degree) {
+    if (!spans.empty() && spans.back().end() == data)
+        spans.back() =
+            Span<T>(spans.back().data(), spans.back().size() + degree);
+    else
+        spans.emplace_back(data, degree);
+}
+
+template <class T, class GetData>
+std::vector<Span<T>> collectResidues(u64 size, u64 level, u64 degree,
+                                     GetData &&get_data) {
+    std::vector<Span<T>> spans;
+    for (u64 i = 0; i < size; ++i)
+        for (u64 l = 0; l <= level; ++l)
+            appendResidues<T>(spans, get_data(i, l), degree);
+    return spans;
+}
+
+void checkCiphertext(const char *func, const Ciphertext &ctxt) {
+    if (!detail::isOnCPU(ctxt.getDevice()))
+        throw RuntimeException(std::string{"["} + func +
+                               "] The ciphertext should reside on CPU");
+    if (ctxt.isModUp())
+        throw RuntimeException(std::string{"["} + func +
+                               "] Mod-up ciphertexts are not supported");
+}
+
+} // namespace
+
+ResidueLayout::ResidueLayout(const Context &context)
+    : degree_{detail::getDegree(context)},
+      max_level_{detail::getMaxLevel(context)} {}
+
+std::vector<Span<const u64>>
+ResidueLayout::getResidues(const Ciphertext &ctxt) const {
+    checkCiphertext("ResidueLayout::getResidues", ctxt);
+    return collectResidues<const u64>(
+        ctxt.getSize(), ctxt.getLevel(), degree_,
+        [&](u64 i, u64 l) { return ctxt.getPolyData(i, l); });
+}
+
+std::vector<Span<const u64>>
+ResidueLayout::getResidues(const Plaintext &ptxt) const {
+    if (!detail::isOnCPU(ptxt.getDevice()))
+        throw RuntimeException("[ResidueLayout::getResidues] The plaintext "
+                               "should reside on CPU");
+    return collectResidues<const u64>(
+        1, ptxt.getLevel(), degree_,
+        [&](u64, u64 l) { return ptxt.getMxData(l); });
+}
+
+std::vector<Span<u64>> ResidueLayout::prepareResidues(Ciphertext &ctxt,
+                                                      u64 size,
+                                                      u64 level) const {
+    checkCiphertext("ResidueLayout::prepareResidues", ctxt);
+    if (size < 2 || size > detail::MAX_CIPHERTEXT_SIZE)
+        throw RuntimeException("[ResidueLayout::prepareResidues] The size "
+                               "should be 2 or 3");
+    if (level > max_level_)
+        throw RuntimeException("[ResidueLayout::prepareResidues] The level "
+                               "exceeds the maximal level of the context");
+    // Raising the size or the level allocates what the ciphertext lacks.
+    ctxt.setSize(size);
+    ctxt.setLevel(level);
+    return collectResidues<u64>(
+        size, level, degree_,
+        [&](u64 i, u64 l) { return ctxt.getPolyData(i, l); });
+}
+
+std::vector<Span<u64>> ResidueLayout::prepareResidues(Plaintext &ptxt,
+                                                      u64 level) const {
+    if (!detail::isOnCPU(ptxt.getDevice()))
+        throw RuntimeException("[ResidueLayout::prepareResidues] The "
+                               "plaintext should reside on CPU");
+    if (level > max_level_)
+        throw RuntimeException("[ResidueLayout::prepareResidues] The level "
+                               "exceeds the maximal level of the context");
+    ptxt.setLevel(level);
+    return collectResidues<u64>(1, level, degree_,
+                                [&](u64, u64 l) { return ptxt.getMxData(l); });
+}
+
+void ResidueLayout::exportFlat(const Ciphertext &ctxt, Span<u64> out) const {
+    checkCiphertext("ResidueLayout::exportFlat", ctxt);
+    const u64 size = ctxt.getSize();
+    const u64 level = ctxt.getLevel();
+    if (out.size() != getFlatSize(size, level))
+        throw RuntimeException("[ResidueLayout::exportFlat] The buffer does "
+                               "not match the size and level of the "
+                               "ciphertext");
+    parallelFor(size * (level + 1), [&](u64 index) {
+        const u64 i = index / (level + 1);
+        const u64 l = index % (level + 1);
+        std::copy_n(ctxt.getPolyData(i, l), degree_,
+                    out.data() + index * degree_);
+    });
+}
+
+void ResidueLayout::importFlat(Span<const u64> in, u64 size, u64 level,
+                               Ciphertext &ctxt) const {
+    // Bound size and level before getFlatSize, which could overflow.
+    if (size < 2 || size > detail::MAX_CIPHERTEXT_SIZE || level > max_level_)
+        throw RuntimeException("[ResidueLayout::importFlat] The size should "
+                               "be 2 or 3 and the level should not exceed "
+                               "the maximal level of the context");
+    if (in.size() != getFlatSize(size, level))
+        throw RuntimeException("[ResidueLayout::importFlat] The buffer does "
+                               "not match the size and level");
+    prepareResidues(ctxt, size, level);
+    parallelFor(size * (level + 1), [&](u64 index) {
+        const u64 i = index / (level + 1);
+        const u64 l = index % (level + 1);
+        std::copy_n(in.data() + index * degree_, degree_,
+                    ctxt.getPolyData(i, l));
+    });
+}
+
+} // namespace HEaaN
@@ -0,0 +1,166 @@
+////////////////////////////////////////////////////////////////////////////////
+//                                                                            //
+// Copyright (C) 2021-2023 Crypto Lab Inc.                                    //
+//                                                                            //
+// - This file is part of HEaaN homomorphic encryption library.               //
+// - HEaaN cannot be copied and/or distributed without the express permission //
+//  of Crypto Lab Inc.                                                        //
+//                                                                            //
+////////////////////////////////////////////////////////////////////////////////
+
+#include "HEaaN/RotationKeyCache.hpp"
+
+#include <exception>
+#include <string>
+#include <utility>
+
+#include "HEaaN/Exception.hpp"
+#include "HEaaN/KeyPack.hpp"
+
+namespace HEaaN {
+
+RotationKeyCache::RotationKeyCache(const Context &context,
+                                   const KeyStore &store, u64 memory_budget)
+    : context_{context}, store_{store}, memory_budget_{memory_budget},
+      memory_usage_{0}, num_hits_{0}, num_misses_{0}, load_time_{0} {}
+
+void RotationKeyCache::leftRotate(const Ciphertext &ctxt, u64 rot,
+                                  Ciphertext &ctxt_out) {
+    const u64 num_slots = ctxt.getNumberOfSlots();
+    const u64 key_rot = rot % num_slots;
+    if (key_rot == 0) {
+        ctxt_out = ctxt;
+        return;
+    }
+    getEvaluator(key_rot)->leftRotate(ctxt, key_rot, ctxt_out);
+}
+
+void RotationKeyCache::rightRotate(const Ciphertext &ctxt, u64 rot,
+                                   Ciphertext &ctxt_out) {
+    const u64 num_slots = ctxt.getNumberOfSlots();
+    leftRotate(ctxt, num_slots - rot % num_slots, ctxt_out);
+}
+
+std::shared_ptr<const HomEvaluator> RotationKeyCache::getEvaluator(u64 rot) {
+    std::promise<std::shared_ptr<const HomEvaluator>> promise;
+    {
+        std::unique_lock<std::mutex> lock(mutex_);
+        auto it = cache_.find(rot);
+        if (it != cache_.end()) {
+            lru_.splice(lru_.begin(), lru_, it->second.lru_pos);
+            ++num_hits_;
+            return it->second.eval;
+        }
+        auto loading = loading_.find(rot);
+        if (loading != loading_.end()) {
+            // Wait for the thread already loading the key rather than load it
+            // twice. get() rethrows if that load failed.
+            ++num_hits_;
+            EvaluatorFuture future = loading->second;
+            lock.unlock();
+            return future.get();
+        }
+        ++num_misses_;
+        loading_.emplace(rot, promise.get_future().share());
+    }
+
+    // Load without holding the lock so that loaded keys are served
+    // meanwhile.
+    std::shared_ptr<const HomEvaluator> eval;
+    try {
+        eval = loadEvaluator(rot);
+    } catch (...) {
+        promise.set_exception(std::current_exception());
+        std::lock_guard<std::mutex> lock(mutex_);
+        loading_.erase(rot);
+        throw;
+    }
+    promise.set_value(eval);
+    std::lock_guard<std::mutex> lock(mutex_);
+    loading_.erase(rot);
+    return eval;
+}
+
+std::shared_ptr<const HomEvaluator>
+RotationKeyCache::loadEvaluator(u64 rot) {
+    if (!store_.hasLeftRotKey(rot))
+        throw RuntimeException("[RotationKeyCache::getEvaluator] No left "
+                               "rotation key by " +
+                               std::to_string(rot));
+
+    const auto start = std::chrono::steady_clock::now();
+    KeyPack keypack(context_);
+    store_.loadLeftRotKey(keypack, rot);
+    auto eval = std::make_shared<const HomEvaluator>(context_, keypack);
+    const auto elapsed = std::chrono::steady_clock::now() - start;
+    const u64 bytes = store_.getLeftRotKeySize(rot);
+
+    std::lock_guard<std::mutex> lock(mutex_);
+    load_time_ +=
+        std::chrono::duration_cast<std::chrono::nanoseconds>(elapsed);
+    lru_.push_front(rot);
+    cache_.emplace(rot, Entry{eval, bytes, lru_.begin()});
+    memory_usage_ += bytes;
+    evictToBudget();
+    return eval;
+}
+
+u64 RotationKeyCache::getMemoryBudget() const {
+    std::lock_guard<std::mutex> lock(mutex_);
+    return memory_budget_;
+}
+
+void RotationKeyCache::setMemoryBudget(u64 memory_budget) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    memory_budget_ = memory_budget;
+    evictToBudget();
+}
+
+u64 RotationKeyCache::getMemoryUsage() const {
+    std::lock_guard<std::mutex> lock(mutex_);
+    return memory_usage_;
+}
+
+u64 RotationKeyCache::getNumLoadedKeys() const {
+    std::lock_guard<std::mutex> lock(mutex_);
+    return cache_.size();
+}
+
+u64 RotationKeyCache::getNumHits() const {
+    std::lock_guard<std::mutex> lock(mutex_);
+    return num_hits_;
+}
+
+u64 RotationKeyCache::getNumMisses() const {
+    std::lock_guard<std::mutex> lock(mutex_);
+    return num_misses_;
+}
+
+std::chrono::nanoseconds RotationKeyCache::getLoadTime() const {
+    std::lock_guard<std::mutex> lock(mutex_);
+    return load_time_;
+}
+
+void RotationKeyCache::clear() {
+    std::lock_guard<std::mutex> lock(mutex_);
+    cache_.clear();
+    lru_.clear();
+    memory_usage_ = 0;
+    num_hits_ = 0;
+    num_misses_ = 0;
+    load_time_ = std::chrono::nanoseconds{0};
+}
+
+void RotationKeyCache::evictToBudget() {
+    if (memory_budget_ == 0)
+        return;
+    // The most recently used key is kept even if it alone exceeds the budget.
+    while (memory_usage_ > memory_budget_ && lru_.size() > 1) {
+        auto it = cache_.find(lru_.back());
+        memory_usage_ -= it->second.bytes;
+        cache_.erase(it);
+        lru_.pop_back();
+    }
+}
+
+} // namespace HEaaN
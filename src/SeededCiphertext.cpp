@@ -0,0 +1,229 @@
+////////////////////////////////////////////////////////////////////////////////
+//                                                                            //
+// Copyright (C) 2021-2023 Crypto Lab Inc.                                    //
+//                                                                            //
+// - This file is part of HEaaN homomorphic encryption library.               //
+// - HEaaN cannot be copied and/or distributed without the express permission //
+//  of Crypto Lab Inc.                                                        //
+//                                                                            //
+////////////////////////////////////////////////////////////////////////////////
+
+#include "HEaaN/SeededCiphertext.hpp"
+
+#include <algorithm>
+#include <cmath>
+#include <fstream>
+#include <iterator>
+#include <limits>
+
+#include "ChaCha20.hpp"
+#include "ContextUtil.hpp"
+#include "HEaaN/EnDecoder.hpp"
+#include "HEaaN/Exception.hpp"
+#include "HEaaN/Plaintext.hpp"
+#include "NTT.hpp"
+#include "ParallelFor.hpp"
+#include "StreamUtil.hpp"
+
+namespace HEaaN {
+
+namespace {
+
+// "HEaaNSCT" in little endian
+constexpr u64 MAGIC = 0x5443534e61614548ULL;
+constexpr u64 VERSION = 1;
+constexpr double ERROR_STDDEV = 3.2;
+// Streams of a seed: the uniform part at level l uses stream l, the error
+// uses ERROR_STREAM of its own secret seed.
+constexpr u64 ERROR_STREAM = ~U64ZERO;
+
+// Rounded Gaussian error coefficients by the Box-Muller transform
+std::vector<i64> sampleError(u64 degree) {
+    detail::ChaCha20 stream(detail::drawSeed(), ERROR_STREAM);
+    std::vector<i64> error(degree);
+    for (u64 i = 0; i < degree; i += 2) {
+        const double radius =
+            ERROR_STDDEV * std::sqrt(-2.0 * std::log(1.0 - stream.nextUnit()));
+        const double angle = 2.0 * M_PI * stream.nextUnit();
+        error[i] = std::llround(radius * std::cos(angle));
+        if (i + 1 < degree)
+            error[i + 1] = std::llround(radius * std::sin(angle));
+    }
+    return error;
+}
+
+// Uniform part at one level in evaluation form
+void expandUniform(const SeedType &seed, u64 level, u64 prime, u64 degree,
+                   u64 *out) {
+    detail::ChaCha20 stream(seed, level);
+    for (u64 i = 0; i < degree; ++i)
+        out[i] = stream.nextBelow(prime);
+}
+
+} // namespace
+
+SeededCiphertext::SeededCiphertext(const Context &context)
+    : context_{context} {}
+
+void SeededCiphertext::expand(Ciphertext &ctxt) const {
+    if (b_.empty())
+        throw RuntimeException("[SeededCiphertext::expand] The ciphertext is "
+                               "empty");
+
+    // Write into ctxt when its buffers already hold the levels; the buffers
+    // of a ciphertext at a lower level are not guaranteed to be reusable.
+    const bool in_place = detail::isOnCPU(ctxt.getDevice()) &&
+                          !ctxt.isModUp() && ctxt.getSize() == 2 &&
+                          ctxt.getLevel() >= level_;
+    Ciphertext fresh(context_);
+    Ciphertext &out = in_place ? ctxt : fresh;
+    out.setLevel(level_);
+    out.setRescaleCounter(r_counter_);
+    out.setLogSlots(log_slots_);
+
+    const auto primes = getPrimeList(context_);
+    const u64 degree = detail::getDegree(context_);
+    parallelFor(level_ + 1, [&](u64 l) {
+        std::copy_n(b_.data() + l * degree, degree, out.getPolyData(0, l));
+        expandUniform(seed_, l, primes[l], degree, out.getPolyData(1, l));
+    });
+    if (!in_place)
+        ctxt = std::move(fresh);
+}
+
+void SeededCiphertext::save(std::ostream &stream) const {
+    if (b_.empty())
+        throw RuntimeException("[SeededCiphertext::save] The ciphertext is "
+                               "empty");
+    const u64 header[] = {MAGIC,
+                          VERSION,
+                          detail::getDegree(context_),
+                          level_,
+                          static_cast<u64>(static_cast<i64>(r_counter_)),
+                          log_slots_};
+    detail::writeWords(stream, header, std::size(header));
+    detail::writeWords(stream, seed_.data(), seed_.size());
+    detail::writeWords(stream, b_.data(), b_.size());
+}
+
+void SeededCiphertext::save(const std::string &path) const {
+    std::ofstream stream(path, std::ios::binary);
+    if (!stream)
+        throw RuntimeException("[SeededCiphertext::save] Cannot open " + path);
+    save(stream);
+}
+
+void SeededCiphertext::load(std::istream &stream) {
+    u64 header[6];
+    detail::readWords(stream, header, std::size(header),
+                      "SeededCiphertext::load");
+    const u64 degree = detail::getDegree(context_);
+    if (header[0] != MAGIC || header[1] != VERSION)
+        throw RuntimeException("[SeededCiphertext::load] The stream does not "
+                               "hold a seeded ciphertext");
+    const u64 max_level = detail::getMaxLevel(context_);
+    if (header[2] != degree || header[3] > max_level ||
+        header[4] > static_cast<u64>(std::numeric_limits<int>::max()) ||
+        header[5] > getLogFullSlots(context_))
+        throw RuntimeException("[SeededCiphertext::load] The ciphertext does "
+                               "not fit the context");
+
+    SeedType seed;
+    detail::readWords(stream, seed.data(), seed.size(),
+                      "SeededCiphertext::load");
+    std::vector<u64> b((header[3] + 1) * degree);
+    detail::readWords(stream, b.data(), b.size(), "SeededCiphertext::load");
+    const auto primes = getPrimeList(context_);
+    for (u64 l = 0; l <= header[3]; ++l)
+        if (std::any_of(b.begin() + l * degree, b.begin() + (l + 1) * degree,
+                        [&](u64 value) { return value >= primes[l]; }))
+            throw RuntimeException("[SeededCiphertext::load] The ciphertext "
+                                   "does not fit the primes of the context");
+
+    seed_ = seed;
+    level_ = header[3];
+    r_counter_ = static_cast<int>(static_cast<i64>(header[4]));
+    log_slots_ = header[5];
+    b_ = std::move(b);
+}
+
+void SeededCiphertext::load(const std::string &path) {
+    std::ifstream stream(path, std::ios::binary);
+    if (!stream)
+        throw RuntimeException("[SeededCiphertext::load] Cannot open " + path);
+    load(stream);
+}
+
+SeededEncryptor::SeededEncryptor(const Context &context, const SecretKey &sk)
+    : context_{context} {
+    if (!detail::isOnCPU(sk.getDevice()))
+        throw RuntimeException("[SeededEncryptor] The secret key should "
+                               "reside on CPU");
+
+    const auto primes = getPrimeList(context);
+    const u64 degree = detail::getDegree(context);
+    const u64 num_levels = getEncryptionLevel(context) + 1;
+    const SecretKey::Coefficients coeffs = sk.getCoefficients();
+    ntts_.resize(num_levels);
+    sx_.resize(num_levels);
+    parallelFor(num_levels, [&](u64 l) {
+        auto ntt = std::make_shared<const detail::NTT>(primes[l], degree);
+        std::vector<u64> sx(degree);
+        ntt->forward(coeffs, sx.data());
+        ntts_[l] = std::move(ntt);
+        sx_[l] = std::move(sx);
+    });
+}
+
+void SeededEncryptor::encrypt(const Message &msg,
+                              SeededCiphertext &ctxt) const {
+    encrypt(msg, ctxt, getEncryptionLevel(context_));
+}
+
+void SeededEncryptor::encrypt(const Message &msg, SeededCiphertext &ctxt,
+                              u64 level, int r_counter) const {
+    if (!detail::isOnCPU(msg.getDevice()))
+        throw RuntimeException("[SeededEncryptor::encrypt] The message should "
+                               "reside on CPU");
+    if (level >= sx_.size())
+        throw RuntimeException("[SeededEncryptor::encrypt] The level exceeds "
+                               "the encryption level");
+
+    const Plaintext ptxt =
+        EnDecoder(context_).encodeWithoutNTT(msg, level, r_counter);
+    const u64 degree = detail::getDegree(context_);
+    const std::vector<i64> error = sampleError(degree);
+    const SeedType seed = detail::drawSeed();
+
+    // b = -a * s + e + m, with e + m transformed once per level
+    std::vector<u64> b((level + 1) * degree);
+    parallelFor(level + 1, [&](u64 l) {
+        const detail::Modulus &modulus = ntts_[l]->getModulus();
+        const u64 prime = modulus.getPrime();
+        const u64 *mx = ptxt.getMxData(l);
+        u64 *bx = b.data() + l * degree;
+        for (u64 i = 0; i < degree; ++i) {
+            const u64 e = error[i] < 0 ? prime - static_cast<u64>(-error[i])
+                                       : static_cast<u64>(error[i]);
+            const u64 sum = mx[i] + e;
+            bx[i] = sum >= prime ? sum - prime : sum;
+        }
+        ntts_[l]->forward(bx);
+
+        detail::ChaCha20 stream(seed, l);
+        const u64 *sx = sx_[l].data();
+        for (u64 i = 0; i < degree; ++i) {
+            const u64 as = modulus.mul(stream.nextBelow(prime), sx[i]);
+            bx[i] = bx[i] >= as ? bx[i] - as : bx[i] + prime - as;
+        }
+    });
+
+    ctxt = SeededCiphertext(context_);
+    ctxt.seed_ = seed;
+    ctxt.level_ = level;
+    ctxt.r_counter_ = r_counter;
+    ctxt.log_slots_ = msg.getLogSlots();
+    ctxt.b_ = std::move(b);
+}
+
+} // namespace HEaaN
@@ -0,0 +1,352 @@
+////////////////////////////////////////////////////////////////////////////////
+//                                                                            //
+// Copyright (C) 2021-2023 Crypto Lab Inc.                                    //
+//                                                                            //
+// - This file is part of HEaaN homomorphic encryption library.               //
+// - HEaaN cannot be copied and/or distributed without the express permission //
+//  of Crypto Lab Inc.                                                        //
+//                                                                            //
+////////////////////////////////////////////////////////////////////////////////
+
+#include "HEaaN/SeededEvaluationKey.hpp"
+
+#include <algorithm>
+#include <atomic>
+#include <cstring>
+#include <fstream>
+#include <iterator>
+#include <sstream>
+
+#include "ChaCha20.hpp"
+#include "ContextUtil.hpp"
+#include "HEaaN/Exception.hpp"
+#include "MappedFile.hpp"
+#include "NTT.hpp"
+#include "ParallelFor.hpp"
+#include "StreamUtil.hpp"
+
+namespace HEaaN {
+
+namespace {
+
+// "HEaaNSEK" in little endian
+constexpr u64 MAGIC = 0x4b45534e61614548ULL;
+constexpr u64 VERSION = 1;
+
+// Layout of HEaaN::save(const EvaluationKey &, std::ostream &): a key header
+// holding the type of the key at TYPE_OFFSET and the rotation index after it,
+// then the b vector and the a vector, each a count followed by polynomials.
+// A polynomial is a header holding N at DEGREE_OFFSET, its number of primes
+// at NUM_PRIMES_OFFSET and its number of words at NUM_WORDS_OFFSET, then the
+// residues of every prime of the context, N words each.
+constexpr u64 KEY_HEADER_SIZE = 21;
+constexpr u64 TYPE_OFFSET = 12;
+constexpr u64 ROT_OFFSET = 13;
+constexpr u64 COUNT_SIZE = 8;
+constexpr u64 POLY_HEADER_SIZE = 41;
+constexpr u64 DEGREE_OFFSET = 0;
+constexpr u64 NUM_PRIMES_OFFSET = 16;
+constexpr u64 NUM_WORDS_OFFSET = 33;
+
+constexpr char MULT_KEY_TYPE = 'm';
+constexpr char CONJ_KEY_TYPE = 'c';
+constexpr char ROT_KEY_TYPE = 'r';
+
+u64 readWord(const char *bytes) {
+    u64 word;
+    std::memcpy(&word, bytes, sizeof(u64));
+    return word;
+}
+
+bool isPolyHeader(const char *header, u64 num_primes, u64 degree) {
+    return readWord(header + DEGREE_OFFSET) == degree &&
+           readWord(header + NUM_PRIMES_OFFSET) == num_primes &&
+           readWord(header + NUM_WORDS_OFFSET) == num_primes * degree;
+}
+
+// Number of polynomials of b in a serialized key of which bytes holds at
+// least the key header, b and the count of a, or zero if those do not have
+// the layout of a multiplication, conjugation or rotation key over num_primes
+// primes
+u64 parseKeyPrefix(const char *bytes, u64 size, u64 num_primes, u64 degree,
+                   u64 num_slots) {
+    if (size < KEY_HEADER_SIZE + COUNT_SIZE)
+        return 0;
+    const char type = bytes[TYPE_OFFSET];
+    const u64 rot = readWord(bytes + ROT_OFFSET);
+    if ((type != MULT_KEY_TYPE && type != CONJ_KEY_TYPE &&
+         type != ROT_KEY_TYPE) ||
+        (type == ROT_KEY_TYPE ? rot == 0 || rot >= num_slots : rot != 0))
+        return 0;
+    // A key has at most one polynomial per prime, which also keeps the
+    // offsets below from overflowing.
+    const u64 num_polys = readWord(bytes + KEY_HEADER_SIZE);
+    if (num_polys == 0 || num_polys > num_primes)
+        return 0;
+    const u64 poly_size = POLY_HEADER_SIZE + num_primes * degree * sizeof(u64);
+    const u64 b_offset = KEY_HEADER_SIZE + COUNT_SIZE;
+    const u64 a_count_offset = b_offset + num_polys * poly_size;
+    if (size < a_count_offset + COUNT_SIZE ||
+        readWord(bytes + a_count_offset) != num_polys)
+        return 0;
+    for (u64 j = 0; j < num_polys; ++j)
+        if (!isPolyHeader(bytes + b_offset + j * poly_size, num_primes,
+                          degree))
+            return 0;
+    return num_polys;
+}
+
+// Uniform residues of the index-th polynomial of a, in evaluation form. The
+// residues modulo the i-th prime use stream index * (number of primes) + i.
+void expandUniform(const SeedType &seed, u64 index,
+                   const std::vector<u64> &primes, u64 degree, char *out) {
+    const u64 num_primes = primes.size();
+    parallelFor(num_primes, [&](u64 i) {
+        detail::ChaCha20 stream(seed, index * num_primes + i);
+        char *residues = out + i * degree * sizeof(u64);
+        for (u64 k = 0; k < degree; ++k) {
+            const u64 value = stream.nextBelow(primes[i]);
+            std::memcpy(residues + k * sizeof(u64), &value, sizeof(u64));
+        }
+    });
+}
+
+} // namespace
+
+SeededEvaluationKey::SeededEvaluationKey(const Context &context)
+    : context_{context} {}
+
+u64 SeededEvaluationKey::getExpandedSize() const {
+    const u64 num_polys = a_headers_.size() / POLY_HEADER_SIZE;
+    const u64 poly_bytes = getPrimeList(context_).size() *
+                           detail::getDegree(context_) * sizeof(u64);
+    return prefix_.size() + a_headers_.size() + num_polys * poly_bytes;
+}
+
+void SeededEvaluationKey::expand(std::ostream &stream) const {
+    if (prefix_.empty())
+        throw RuntimeException("[SeededEvaluationKey::expand] The key is "
+                               "empty");
+
+    const auto primes = getPrimeList(context_);
+    const u64 degree = detail::getDegree(context_);
+    std::vector<char> residues(primes.size() * degree * sizeof(u64));
+    stream.write(prefix_.data(), static_cast<std::streamsize>(prefix_.size()));
+    for (u64 j = 0; j * POLY_HEADER_SIZE < a_headers_.size(); ++j) {
+        stream.write(a_headers_.data() + j * POLY_HEADER_SIZE,
+                     static_cast<std::streamsize>(POLY_HEADER_SIZE));
+        expandUniform(seed_, j, primes, degree, residues.data());
+        stream.write(residues.data(),
+                     static_cast<std::streamsize>(residues.size()));
+    }
+}
+
+void SeededEvaluationKey::loadInto(KeyPack &keypack) const {
+    if (prefix_.empty())
+        throw RuntimeException("[SeededEvaluationKey::loadInto] The key is "
+                               "empty");
+
+    // Expand into one buffer read in place, rather than through a
+    // stringstream which would hold the key twice.
+    const auto primes = getPrimeList(context_);
+    const u64 degree = detail::getDegree(context_);
+    const u64 poly_bytes = primes.size() * degree * sizeof(u64);
+    std::vector<char> bytes(getExpandedSize());
+    char *out = std::copy(prefix_.begin(), prefix_.end(), bytes.data());
+    for (u64 j = 0; j * POLY_HEADER_SIZE < a_headers_.size(); ++j) {
+        out = std::copy_n(a_headers_.data() + j * POLY_HEADER_SIZE,
+                          POLY_HEADER_SIZE, out);
+        expandUniform(seed_, j, primes, degree, out);
+        out += poly_bytes;
+    }
+
+    detail::MemoryStreamBuf buf(bytes.data(), bytes.size());
+    std::istream stream(&buf);
+    const char type = prefix_[TYPE_OFFSET];
+    if (type == MULT_KEY_TYPE)
+        keypack.loadMultKey(stream);
+    else if (type == CONJ_KEY_TYPE)
+        keypack.loadConjKey(stream);
+    else
+        keypack.loadLeftRotKey(readWord(prefix_.data() + ROT_OFFSET), stream);
+}
+
+void SeededEvaluationKey::save(std::ostream &stream) const {
+    if (prefix_.empty())
+        throw RuntimeException("[SeededEvaluationKey::save] The key is empty");
+    const u64 header[] = {MAGIC,
+                          VERSION,
+                          detail::getDegree(context_),
+                          getPrimeList(context_).size(),
+                          prefix_.size(),
+                          a_headers_.size()};
+    detail::writeWords(stream, header, std::size(header));
+    detail::writeWords(stream, seed_.data(), seed_.size());
+    stream.write(prefix_.data(), static_cast<std::streamsize>(prefix_.size()));
+    stream.write(a_headers_.data(),
+                 static_cast<std::streamsize>(a_headers_.size()));
+}
+
+void SeededEvaluationKey::save(const std::string &path) const {
+    std::ofstream stream(path, std::ios::binary);
+    if (!stream)
+        throw RuntimeException("[SeededEvaluationKey::save] Cannot open " +
+                               path);
+    save(stream);
+}
+
+void SeededEvaluationKey::load(std::istream &stream) {
+    u64 header[6];
+    detail::readBytes(stream, reinterpret_cast<char *>(header),
+                      sizeof(header), "SeededEvaluationKey::load");
+    if (header[0] != MAGIC || header[1] != VERSION)
+        throw RuntimeException("[SeededEvaluationKey::load] The stream does "
+                               "not hold a seeded evaluation key");
+
+    // The sizes are those of a key with as many polynomials as a headers,
+    // at most one per prime, each over every prime of the context.
+    const u64 degree = detail::getDegree(context_);
+    const auto primes = getPrimeList(context_);
+    const u64 num_primes = primes.size();
+    const u64 poly_size = POLY_HEADER_SIZE + num_primes * degree * sizeof(u64);
+    const u64 num_polys = header[5] / POLY_HEADER_SIZE;
+    if (header[2] != degree || header[3] != num_primes || num_polys == 0 ||
+        num_polys > num_primes || header[5] % POLY_HEADER_SIZE != 0 ||
+        header[4] != KEY_HEADER_SIZE + 2 * COUNT_SIZE + num_polys * poly_size)
+        throw RuntimeException("[SeededEvaluationKey::load] The key does not "
+                               "fit the context");
+
+    SeedType seed;
+    detail::readBytes(stream, reinterpret_cast<char *>(seed.data()),
+                      sizeof(seed), "SeededEvaluationKey::load");
+    std::string prefix(header[4], '\0');
+    detail::readBytes(stream, prefix.data(), prefix.size(),
+                      "SeededEvaluationKey::load");
+    std::string a_headers(header[5], '\0');
+    detail::readBytes(stream, a_headers.data(), a_headers.size(),
+                      "SeededEvaluationKey::load");
+
+    // The bytes go to the key parser of the library on loadInto() and
+    // expand(), so check them as compress() checks a key it is given, and
+    // check that b is reduced modulo the primes.
+    const u64 num_slots = U64ONE << getLogFullSlots(context_);
+    bool valid = parseKeyPrefix(prefix.data(), prefix.size(), num_primes,
+                                degree, num_slots) == num_polys;
+    for (u64 j = 0; valid && j < num_polys; ++j)
+        valid = isPolyHeader(a_headers.data() + j * POLY_HEADER_SIZE,
+                             num_primes, degree);
+    if (!valid)
+        throw RuntimeException("[SeededEvaluationKey::load] The key is not a "
+                               "multiplication, conjugation or rotation key "
+                               "of the context");
+    std::atomic<bool> reduced{true};
+    parallelFor(num_polys * num_primes, [&](u64 index) {
+        const u64 j = index / num_primes;
+        const u64 i = index % num_primes;
+        const char *bx = prefix.data() + KEY_HEADER_SIZE + COUNT_SIZE +
+                         j * poly_size + POLY_HEADER_SIZE +
+                         i * degree * sizeof(u64);
+        for (u64 k = 0; k < degree; ++k)
+            if (readWord(bx + k * sizeof(u64)) >= primes[i])
+                reduced = false;
+    });
+    if (!reduced)
+        throw RuntimeException("[SeededEvaluationKey::load] The key does not "
+                               "fit the primes of the context");
+
+    seed_ = seed;
+    prefix_ = std::move(prefix);
+    a_headers_ = std::move(a_headers);
+}
+
+void SeededEvaluationKey::load(const std::string &path) {
+    std::ifstream stream(path, std::ios::binary);
+    if (!stream)
+        throw RuntimeException("[SeededEvaluationKey::load] Cannot open " +
+                               path);
+    load(stream);
+}
+
+SeededKeyCompressor::SeededKeyCompressor(const Context &context,
+                                         const SecretKey &sk)
+    : context_{context} {
+    if (!detail::isOnCPU(sk.getDevice()))
+        throw RuntimeException("[SeededKeyCompressor] The secret key should "
+                               "reside on CPU");
+
+    const auto primes = getPrimeList(context);
+    const u64 degree = detail::getDegree(context);
+    const SecretKey::Coefficients coeffs = sk.getCoefficients();
+    ntts_.resize(primes.size());
+    sx_.resize(primes.size());
+    parallelFor(primes.size(), [&](u64 i) {
+        auto ntt = std::make_shared<const detail::NTT>(primes[i], degree);
+        std::vector<u64> sx(degree);
+        ntt->forward(coeffs, sx.data());
+        ntts_[i] = std::move(ntt);
+        sx_[i] = std::move(sx);
+    });
+}
+
+void SeededKeyCompressor::compress(const EvaluationKey &key,
+                                   SeededEvaluationKey &seeded) const {
+    std::ostringstream out;
+    save(key, out);
+    std::string bytes = out.str();
+
+    const u64 num_primes = sx_.size();
+    const u64 degree = detail::getDegree(context_);
+    const u64 poly_size = POLY_HEADER_SIZE + num_primes * degree * sizeof(u64);
+    const auto checkLayout = [&](bool valid) {
+        if (!valid)
+            throw RuntimeException("[SeededKeyCompressor::compress] "
+                                   "Unrecognized key layout");
+    };
+    const u64 num_polys =
+        parseKeyPrefix(bytes.data(), bytes.size(), num_primes, degree,
+                       U64ONE << getLogFullSlots(context_));
+    const u64 b_offset = KEY_HEADER_SIZE + COUNT_SIZE;
+    const u64 a_offset = b_offset + num_polys * poly_size + COUNT_SIZE;
+    checkLayout(num_polys != 0 &&
+                bytes.size() == a_offset + num_polys * poly_size);
+    for (u64 j = 0; j < num_polys; ++j)
+        checkLayout(isPolyHeader(bytes.data() + a_offset + j * poly_size,
+                                 num_primes, degree));
+
+    // b + (a - a')s = -a's + e + (gadget) for the a' of a fresh seed
+    const SeedType seed = detail::drawSeed();
+    const auto primes = getPrimeList(context_);
+    parallelFor(num_polys * num_primes, [&](u64 index) {
+        const u64 j = index / num_primes;
+        const u64 i = index % num_primes;
+        const u64 residues = POLY_HEADER_SIZE + i * degree * sizeof(u64);
+        char *bx = bytes.data() + b_offset + j * poly_size + residues;
+        const char *ax = bytes.data() + a_offset + j * poly_size + residues;
+        const detail::Modulus &modulus = ntts_[i]->getModulus();
+        const u64 prime = primes[i];
+        const u64 *sx = sx_[i].data();
+        detail::ChaCha20 stream(seed, index);
+        for (u64 k = 0; k < degree; ++k) {
+            const u64 a = readWord(ax + k * sizeof(u64));
+            const u64 a_new = stream.nextBelow(prime);
+            const u64 diff = a >= a_new ? a - a_new : a + prime - a_new;
+            const u64 b = readWord(bx + k * sizeof(u64));
+            const u64 sum = b + modulus.mul(diff, sx[k]);
+            const u64 b_new = sum >= prime ? sum - prime : sum;
+            std::memcpy(bx + k * sizeof(u64), &b_new, sizeof(u64));
+        }
+    });
+
+    std::string a_headers;
+    a_headers.reserve(num_polys * POLY_HEADER_SIZE);
+    for (u64 j = 0; j < num_polys; ++j)
+        a_headers.append(bytes, a_offset + j * poly_size, POLY_HEADER_SIZE);
+    bytes.resize(a_offset);
+
+    seeded = SeededEvaluationKey(context_);
+    seeded.seed_ = seed;
+    seeded.prefix_ = std::move(bytes);
+    seeded.a_headers_ = std::move(a_headers);
+}
+
+} // namespace HEaaN
@@ -0,0 +1,42 @@
+////////////////////////////////////////////////////////////////////////////////
+//                                                                            //
+// Copyright (C) 2021-2023 Crypto Lab Inc.                                    //
+//                                                                            //
+// - This file is part of HEaaN homomorphic encryption library.               //
+// - HEaaN cannot be copied and/or distributed without the express permission //
+//  of Crypto Lab Inc.                                                        //
+//                                                                            //
+////////////////////////////////////////////////////////////////////////////////
+
+#include "HEaaN/SharedCiphertext.hpp"
+
+#include <utility>
+
+namespace HEaaN {
+
+SharedCiphertext::SharedCiphertext(const Context &context, bool is_extended)
+    : ctxt_{std::make_shared<Ciphertext>(context, is_extended)} {}
+
+SharedCiphertext::SharedCiphertext(Ciphertext &&ctxt)
+    : ctxt_{std::make_shared<Ciphertext>(std::move(ctxt))} {}
+
+SharedCiphertext SharedCiphertext::clone() const {
+    return SharedCiphertext(Ciphertext(*ctxt_));
+}
+
+Ciphertext &SharedCiphertext::mutate() {
+    // Other handles are copied from this one or from each other, so once the
+    // count is one it cannot grow behind our back.
+    if (!isUnique())
+        ctxt_ = std::make_shared<Ciphertext>(*ctxt_);
+    return *ctxt_;
+}
+
+Ciphertext SharedCiphertext::release() {
+    auto ctxt = std::move(ctxt_);
+    if (ctxt.use_count() == 1)
+        return std::move(*ctxt);
+    return Ciphertext(*ctxt);
+}
+
+} // namespace HEaaN
@@ -0,0 +1,46 @@
+////////////////////////////////////////////////////////////////////////////////
+//                                                                            //
+// Copyright (C) 2021-2023 Crypto Lab Inc.                                    //
+//                                                                            //
+// - This file is part of HEaaN homomorphic encryption library.               //
+// - HEaaN cannot be copied and/or distributed without the express permission //
+//  of Crypto Lab Inc.                                                        //
+//                                                                            //
+////////////////////////////////////////////////////////////////////////////////
+
+#pragma once
+
+#include <istream>
+#include <ostream>
+#include <string>
+
+#include "HEaaN/Exception.hpp"
+#include "HEaaN/Integers.hpp"
+
+namespace HEaaN::detail {
+
+///@brief Write count words in the byte order of the host
+inline void writeWords(std::ostream &stream, const u64 *words, u64 count) {
+    stream.write(reinterpret_cast<const char *>(words),
+                 static_cast<std::streamsize>(count * sizeof(u64)));
+}
+
+///@brief Read count bytes
+///@throws RuntimeException, prefixed by func, if the stream ends first.
+inline void readBytes(std::istream &stream, char *bytes, u64 count,
+                      const char *func) {
+    stream.read(bytes, static_cast<std::streamsize>(count));
+    if (!stream)
+        throw RuntimeException(std::string{"["} + func +
+                               "] The stream ended before the data");
+}
+
+///@brief Read count words written by writeWords()
+///@throws RuntimeException, prefixed by func, if the stream ends first.
+inline void readWords(std::istream &stream, u64 *words, u64 count,
+                      const char *func) {
+    readBytes(stream, reinterpret_cast<char *>(words), count * sizeof(u64),
+              func);
+}
+
+} // namespace HEaaN::detail
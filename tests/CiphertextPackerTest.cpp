@@ -0,0 +1,103 @@
+////////////////////////////////////////////////////////////////////////////////
+//                                                                            //
+// Copyright (C) 2021-2023 Crypto Lab Inc.                                    //
+//                                                                            //
+// - This file is part of HEaaN homomorphic encryption library.               //
+// - HEaaN cannot be copied and/or distributed without the express permission //
+//  of Crypto Lab Inc.                                                        //
+//                                                                            //
+////////////////////////////////////////////////////////////////////////////////
+
+// Round trips of CiphertextPacker, checked by decryption, and rejection of
+// corrupted headers and residues.
+
+#include <sstream>
+#include <string>
+
+#include "HEaaN/HEaaN.hpp"
+#include "TestUtil.hpp"
+
+using namespace HEaaN;
+using namespace HEaaN::test;
+
+int main() {
+    const Context context = makeContext(ParameterPreset::FX);
+    SecretKey sk(context);
+    KeyGenerator keygen(context, sk);
+    keygen.genMultiplicationKey();
+    KeyPack keypack = keygen.getKeyPack();
+    HomEvaluator eval(context, keypack);
+    Encryptor encryptor(context);
+    Decryptor decryptor(context);
+    CiphertextPacker packer(context);
+
+    Message msg(getLogFullSlots(context));
+    for (u64 i = 0; i < msg.getSize(); ++i)
+        msg[i] = Complex(0.01 * static_cast<Real>(i % 17), -0.3);
+    Ciphertext ctxt(context);
+    encryptor.encrypt(msg, sk, ctxt);
+
+    for (const u64 level : {getEncryptionLevel(context), U64ONE, U64ZERO}) {
+        Ciphertext leveled(context);
+        eval.levelDown(ctxt, level, leveled);
+        std::stringstream stream;
+        packer.save(leveled, stream);
+        check(stream.str().size() == packer.getPackedSize(leveled),
+              "packed size at level " + std::to_string(level));
+
+        Ciphertext loaded(context);
+        packer.load(stream, loaded);
+        Message decrypted;
+        decryptor.decrypt(loaded, sk, decrypted);
+        check(loaded.getLevel() == level &&
+                  loaded.getLogSlots() == leveled.getLogSlots() &&
+                  maxError(decrypted, msg) < 1e-3,
+              "round trip at level " + std::to_string(level));
+    }
+
+    // A product before relinearization has three polynomials.
+    Ciphertext tensored(context);
+    eval.tensor(ctxt, ctxt, tensored);
+    std::stringstream tensored_stream;
+    packer.save(tensored, tensored_stream);
+    Ciphertext tensored_loaded(context);
+    packer.load(tensored_stream, tensored_loaded);
+    Ciphertext product(context);
+    eval.relinearize(tensored_loaded, product);
+    eval.rescale(product);
+    Message squared(msg.getLogSlots());
+    for (u64 i = 0; i < msg.getSize(); ++i)
+        squared[i] = msg[i] * msg[i];
+    Message decrypted;
+    decryptor.decrypt(product, sk, decrypted);
+    check(tensored_loaded.getSize() == 3 &&
+              maxError(decrypted, squared) < 1e-3,
+          "round trip of a tensor product");
+
+    // Header words: magic, version, degree, size, level, rescale counter,
+    // log(number of slots), followed by the packed residues.
+    std::stringstream stream;
+    packer.save(ctxt, stream);
+    const std::string packed = stream.str();
+    const CorruptedInput corrupted[] = {
+        {"magic", patchWord(packed, 0, 0)},
+        {"huge size", patchWord(packed, 3, U64ONE << 40)},
+        {"level above the maximal level", patchWord(packed, 4, 25)},
+        {"negative rescale counter", patchWord(packed, 5, ~U64ZERO)},
+        {"too many slots", patchWord(packed, 6, getLogFullSlots(context) + 1)},
+        {"residue above the prime", patchWord(packed, 7, ~U64ZERO)},
+        {"truncated residues", packed.substr(0, packed.size() - 8)},
+    };
+    for (const auto &[what, bytes] : corrupted) {
+        Ciphertext target(context);
+        eval.levelDown(ctxt, 1, target);
+        const u64 *data = target.getPolyData(0, 0);
+        std::stringstream in(bytes);
+        check(throwsRuntimeException([&] { packer.load(in, target); }),
+              std::string{"rejects "} + what);
+        check(target.getLevel() == 1 && target.getPolyData(0, 0) == data,
+              std::string{"keeps the ciphertext on "} + what);
+    }
+
+    return finish("CiphertextPackerTest");
+}
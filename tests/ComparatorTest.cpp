@@ -0,0 +1,89 @@
+////////////////////////////////////////////////////////////////////////////////
+//                                                                            //
+// Copyright (C) 2021-2023 Crypto Lab Inc.                                    //
+//                                                                            //
+// - This file is part of HEaaN homomorphic encryption library.               //
+// - HEaaN cannot be copied and/or distributed without the express permission //
+//  of Crypto Lab Inc.                                                        //
+//                                                                            //
+////////////////////////////////////////////////////////////////////////////////
+
+// Chained max, min and relu from inputs at the minimum level for bootstrap,
+// whose outputs should stay bootstrappable.
+
+#include <algorithm>
+#include <cmath>
+#include <string>
+
+#include "HEaaN/HEaaN.hpp"
+#include "TestUtil.hpp"
+
+using namespace HEaaN;
+using namespace HEaaN::test;
+
+int main() {
+    const Context context = makeContext(ParameterPreset::FX);
+    const u64 log_slots = getLogFullSlots(context);
+    SecretKey sk(context);
+    KeyGenerator keygen(context, sk);
+    keygen.genCommonKeys();
+    keygen.genRotKeysForBootstrap(log_slots);
+    const KeyPack keypack = keygen.getKeyPack();
+    HomEvaluator eval(context, keypack);
+    Bootstrapper btp(eval, log_slots);
+    Comparator comparator(eval, btp);
+    Encryptor encryptor(context);
+    Decryptor decryptor(context);
+    const u64 min_boot_level = btp.getMinLevelForBootstrap();
+
+    Message msg1(log_slots), msg2(log_slots), msg3(log_slots);
+    for (u64 i = 0; i < msg1.getSize(); ++i) {
+        const Real x = static_cast<Real>(i);
+        msg1[i] = Complex(0.3 * std::sin(1.7 * x), 0);
+        msg2[i] = Complex(0.3 * std::cos(0.9 * x), 0);
+        msg3[i] = Complex(0.3 * std::sin(0.4 * x + 1), 0);
+    }
+    Ciphertext ctxt1(context), ctxt2(context), ctxt3(context);
+    encryptor.encrypt(msg1, sk, ctxt1);
+    encryptor.encrypt(msg2, sk, ctxt2);
+    encryptor.encrypt(msg3, sk, ctxt3);
+    eval.levelDown(ctxt1, min_boot_level, ctxt1);
+    eval.levelDown(ctxt2, min_boot_level, ctxt2);
+    eval.levelDown(ctxt3, min_boot_level, ctxt3);
+
+    Ciphertext max12(context), max123(context), min_out(context),
+        relu_out(context);
+    comparator.max(ctxt1, ctxt2, max12);
+    check(max12.getLevel() >= min_boot_level, "level of max(a, b)");
+    comparator.max(max12, ctxt3, max123);
+    check(max123.getLevel() >= min_boot_level, "level of max(max(a, b), c)");
+    comparator.min(max123, ctxt1, min_out);
+    check(min_out.getLevel() >= min_boot_level, "level of min");
+    comparator.relu(ctxt1, relu_out);
+    check(relu_out.getLevel() >= min_boot_level, "level of relu");
+
+    Message expected_max(log_slots), expected_min(log_slots),
+        expected_relu(log_slots);
+    for (u64 i = 0; i < msg1.getSize(); ++i) {
+        const Real max = std::max(
+            {msg1[i].real(), msg2[i].real(), msg3[i].real()});
+        expected_max[i] = Complex(max, 0);
+        expected_min[i] = Complex(std::min(max, msg1[i].real()), 0);
+        expected_relu[i] = Complex(std::max(msg1[i].real(), REAL_ZERO), 0);
+    }
+    Message decrypted;
+    decryptor.decrypt(max123, sk, decrypted);
+    check(maxError(decrypted, expected_max) < 1e-2, "max(max(a, b), c)");
+    decryptor.decrypt(min_out, sk, decrypted);
+    check(maxError(decrypted, expected_min) < 1e-2, "min");
+    decryptor.decrypt(relu_out, sk, decrypted);
+    check(maxError(decrypted, expected_relu) < 1e-2, "relu");
+
+    // Below the minimum level for bootstrap nothing can be done.
+    Ciphertext too_low(context);
+    eval.levelDown(ctxt1, min_boot_level - 1, too_low);
+    check(throwsRuntimeException([&] { comparator.relu(too_low, relu_out); }),
+          "rejects an input below the minimum level for bootstrap");
+
+    return finish("ComparatorTest");
+}
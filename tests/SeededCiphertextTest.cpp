@@ -0,0 +1,125 @@
+////////////////////////////////////////////////////////////////////////////////
+//                                                                            //
+// Copyright (C) 2021-2023 Crypto Lab Inc.                                    //
+//                                                                            //
+// - This file is part of HEaaN homomorphic encryption library.               //
+// - HEaaN cannot be copied and/or distributed without the express permission //
+//  of Crypto Lab Inc.                                                        //
+//                                                                            //
+////////////////////////////////////////////////////////////////////////////////
+
+// Round trips of SeededCiphertext from SeededEncryptor through save, load and
+// expand, checked by decryption, and rejection of corrupted inputs.
+
+#include <sstream>
+#include <string>
+
+#include "HEaaN/HEaaN.hpp"
+#include "TestUtil.hpp"
+
+using namespace HEaaN;
+using namespace HEaaN::test;
+
+int main() {
+    const Context context = makeContext(ParameterPreset::FX);
+    SecretKey sk(context);
+    KeyGenerator keygen(context, sk);
+    keygen.genMultiplicationKey();
+    const KeyPack keypack = keygen.getKeyPack();
+    HomEvaluator eval(context, keypack);
+    SeededEncryptor encryptor(context, sk);
+    Decryptor decryptor(context);
+
+    Message msg(getLogFullSlots(context));
+    for (u64 i = 0; i < msg.getSize(); ++i)
+        msg[i] = Complex(0.01 * static_cast<Real>(i % 17), -0.3);
+
+    // Encrypt, save, load into another object and expand, at the encryption
+    // level and below it
+    std::string saved;
+    for (const u64 level : {getEncryptionLevel(context), U64ONE}) {
+        SeededCiphertext seeded(context);
+        encryptor.encrypt(msg, seeded, level);
+        std::stringstream stream;
+        seeded.save(stream);
+        SeededCiphertext loaded(context);
+        loaded.load(stream);
+        Ciphertext ctxt(context);
+        loaded.expand(ctxt);
+
+        Message decrypted;
+        decryptor.decrypt(ctxt, sk, decrypted);
+        check(ctxt.getLevel() == level &&
+                  ctxt.getLogSlots() == msg.getLogSlots() &&
+                  maxError(decrypted, msg) < 1e-3,
+              "round trip at level " + std::to_string(level));
+
+        std::stringstream full;
+        ctxt.save(full);
+        const u64 full_size = full.str().size();
+        check(2 * stream.str().size() < full_size + full_size / 10,
+              "about half the size at level " + std::to_string(level));
+        if (level == getEncryptionLevel(context))
+            saved = stream.str();
+    }
+
+    // Fewer slots, then a multiplication by the library on the expanded
+    // ciphertext
+    {
+        Message sparse(3);
+        for (u64 i = 0; i < sparse.getSize(); ++i)
+            sparse[i] = Complex(0.1 * static_cast<Real>(i), 0);
+        SeededCiphertext seeded(context);
+        encryptor.encrypt(sparse, seeded, 5);
+        Ciphertext ctxt(context);
+        seeded.expand(ctxt);
+        Ciphertext squared(context);
+        eval.square(ctxt, squared);
+        Message expected(sparse.getLogSlots());
+        for (u64 i = 0; i < sparse.getSize(); ++i)
+            expected[i] = sparse[i] * sparse[i];
+        Message decrypted;
+        decryptor.decrypt(squared, sk, decrypted);
+        check(maxError(decrypted, expected) < 1e-3, "square of a sparse one");
+    }
+
+    // The seed determines the uniform part: another seed does not decrypt.
+    {
+        std::string bytes = saved;
+        bytes[6 * sizeof(u64)] ^= 1;
+        std::stringstream stream(bytes);
+        SeededCiphertext loaded(context);
+        loaded.load(stream);
+        Ciphertext ctxt(context);
+        loaded.expand(ctxt);
+        Message decrypted;
+        decryptor.decrypt(ctxt, sk, decrypted);
+        check(maxError(decrypted, msg) > 1, "depends on the seed");
+    }
+
+    // Header words: magic, version, degree, level, rescale counter,
+    // log(number of slots), followed by the seed and the residues of b.
+    const CorruptedInput corrupted[] = {
+        {"empty input", ""},
+        {"magic", patchWord(saved, 0, 0)},
+        {"version", patchWord(saved, 1, 0)},
+        {"degree", patchWord(saved, 2, 1)},
+        {"level above the maximal level", patchWord(saved, 3, 25)},
+        {"negative rescale counter", patchWord(saved, 4, ~U64ZERO)},
+        {"too many slots", patchWord(saved, 5, getLogFullSlots(context) + 1)},
+        {"residue above the prime", patchWord(saved, 10, ~U64ZERO)},
+        {"truncated residues", saved.substr(0, saved.size() - 8)},
+    };
+    for (const auto &[what, bytes] : corrupted) {
+        SeededCiphertext target(context);
+        encryptor.encrypt(msg, target, 1);
+        const SeedType seed = target.getSeed();
+        std::stringstream stream(bytes);
+        check(throwsRuntimeException([&] { target.load(stream); }),
+              std::string{"rejects "} + what);
+        check(target.getLevel() == 1 && target.getSeed() == seed,
+              std::string{"keeps the ciphertext on "} + what);
+    }
+
+    return finish("SeededCiphertextTest");
+}
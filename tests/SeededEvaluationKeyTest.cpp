@@ -0,0 +1,179 @@
+////////////////////////////////////////////////////////////////////////////////
+//                                                                            //
+// Copyright (C) 2021-2023 Crypto Lab Inc.                                    //
+//                                                                            //
+// - This file is part of HEaaN homomorphic encryption library.               //
+// - HEaaN cannot be copied and/or distributed without the express permission //
+//  of Crypto Lab Inc.                                                        //
+//                                                                            //
+////////////////////////////////////////////////////////////////////////////////
+
+// Round trips of SeededEvaluationKey through save, load, loadInto and expand,
+// checked by decryption after rotation, multiplication and conjugation, and
+// rejection of corrupted inputs.
+
+#include <sstream>
+#include <string>
+#include <utility>
+
+#include "HEaaN/HEaaN.hpp"
+#include "TestUtil.hpp"
+
+using namespace HEaaN;
+using namespace HEaaN::test;
+
+namespace {
+
+// Save a seeded key and load it back as another object.
+SeededEvaluationKey roundTrip(const Context &context,
+                              const SeededEvaluationKey &seeded,
+                              std::string &saved) {
+    std::stringstream stream;
+    seeded.save(stream);
+    saved = stream.str();
+    SeededEvaluationKey loaded(context);
+    loaded.load(stream);
+    return loaded;
+}
+
+} // namespace
+
+int main() {
+    const Context context = makeContext(ParameterPreset::FX);
+    const u64 rot = 3;
+    SecretKey sk(context);
+    KeyGenerator keygen(context, sk);
+    keygen.genMultiplicationKey();
+    keygen.genConjugationKey();
+    keygen.genLeftRotationKey(rot);
+    const KeyPack keypack = keygen.getKeyPack();
+    SeededKeyCompressor compressor(context, sk);
+    Encryptor encryptor(context);
+    Decryptor decryptor(context);
+
+    // Compress every key, save and load it, and load it into a fresh
+    // KeyPack, except for the rotation key which goes through expand().
+    KeyPack seeded_keypack(context);
+    std::string saved_rot_key;
+    for (const auto &[what, key] :
+         {std::pair{"multiplication key", keypack.getMultKey()},
+          std::pair{"conjugation key", keypack.getConjKey()},
+          std::pair{"rotation key", keypack.getLeftRotKey(rot)}}) {
+        SeededEvaluationKey seeded(context);
+        compressor.compress(*key, seeded);
+        std::string saved;
+        const SeededEvaluationKey loaded = roundTrip(context, seeded, saved);
+
+        std::stringstream full;
+        save(*key, full);
+        check(loaded.getExpandedSize() == full.str().size(),
+              std::string{"expanded size of the "} + what);
+        check(2 * saved.size() < full.str().size() + full.str().size() / 10,
+              std::string{"about half the size of the "} + what);
+
+        if (key == keypack.getLeftRotKey(rot)) {
+            saved_rot_key = saved;
+            std::stringstream expanded;
+            loaded.expand(expanded);
+            check(expanded.str().size() == full.str().size(),
+                  "size of the expanded rotation key");
+            seeded_keypack.loadLeftRotKey(rot, expanded);
+        } else {
+            loaded.loadInto(seeded_keypack);
+        }
+    }
+
+    HomEvaluator eval(context, seeded_keypack);
+    Message msg(getLogFullSlots(context));
+    const u64 num_slots = msg.getSize();
+    for (u64 i = 0; i < num_slots; ++i)
+        msg[i] = Complex(0.01 * static_cast<Real>(i % 17),
+                         -0.02 * static_cast<Real>(i % 5));
+    Ciphertext ctxt(context);
+    encryptor.encrypt(msg, sk, ctxt);
+
+    Message rotated(msg.getLogSlots());
+    Message squared(msg.getLogSlots());
+    Message conjugated(msg.getLogSlots());
+    for (u64 i = 0; i < num_slots; ++i) {
+        rotated[i] = msg[(i + rot) % num_slots];
+        squared[i] = msg[i] * msg[i];
+        conjugated[i] = std::conj(msg[i]);
+    }
+
+    Ciphertext ctxt_out(context);
+    Message decrypted;
+    eval.leftRotate(ctxt, rot, ctxt_out);
+    decryptor.decrypt(ctxt_out, sk, decrypted);
+    check(maxError(decrypted, rotated) < 1e-3, "rotation");
+    eval.mult(ctxt, ctxt, ctxt_out);
+    decryptor.decrypt(ctxt_out, sk, decrypted);
+    check(maxError(decrypted, squared) < 1e-3, "multiplication");
+    eval.conjugate(ctxt, ctxt_out);
+    decryptor.decrypt(ctxt_out, sk, decrypted);
+    check(maxError(decrypted, conjugated) < 1e-3, "conjugation");
+
+    // The seed determines the uniform part: another seed gives a wrong key.
+    {
+        std::string bytes = saved_rot_key;
+        bytes[6 * sizeof(u64)] ^= 1;
+        std::stringstream stream(bytes);
+        SeededEvaluationKey loaded(context);
+        loaded.load(stream);
+        KeyPack wrong_keypack(context);
+        loaded.loadInto(wrong_keypack);
+        HomEvaluator wrong_eval(context, wrong_keypack);
+        wrong_eval.leftRotate(ctxt, rot, ctxt_out);
+        decryptor.decrypt(ctxt_out, sk, decrypted);
+        check(maxError(decrypted, rotated) > 1, "depends on the seed");
+    }
+
+    // Header words: magic, version, degree, number of primes, size of the
+    // serialized key up to the first a, size of the a headers, followed by
+    // the seed and the serialized data. The serialized key starts with a key
+    // header holding the type at byte 12 and the rotation index after it,
+    // then the count of b and the polynomials of b, each a header holding
+    // the number of primes at byte 16 and the number of words at byte 33
+    // followed by the residues, then the count of a; the headers of the
+    // polynomials of a come last.
+    const u64 prefix = 10 * sizeof(u64);
+    const u64 prefix_size = readWordAt(saved_rot_key, 4 * sizeof(u64));
+    const u64 b_count = prefix + 21;
+    const u64 b_header = b_count + 8;
+    const u64 a_count = prefix + prefix_size - 8;
+    const u64 a_header = prefix + prefix_size;
+    std::string unknown_type = saved_rot_key;
+    unknown_type[prefix + 12] = 'x';
+    const CorruptedInput corrupted[] = {
+        {"empty input", ""},
+        {"magic", patchWord(saved_rot_key, 0, 0)},
+        {"version", patchWord(saved_rot_key, 1, 0)},
+        {"degree", patchWord(saved_rot_key, 2, 1)},
+        {"number of primes", patchWord(saved_rot_key, 3, 1)},
+        {"huge key size", patchWord(saved_rot_key, 4, U64ONE << 40)},
+        {"size of the a headers", patchWord(saved_rot_key, 5, 1)},
+        {"truncated data", saved_rot_key.substr(0, saved_rot_key.size() - 1)},
+        {"key type", unknown_type},
+        {"zero rotation", patchBytes(saved_rot_key, prefix + 13, 0)},
+        {"rotation beyond the slots",
+         patchBytes(saved_rot_key, prefix + 13, num_slots)},
+        {"count of b", patchBytes(saved_rot_key, b_count, 1)},
+        {"number of primes of b", patchBytes(saved_rot_key, b_header + 16, 1)},
+        {"number of words of b", patchBytes(saved_rot_key, b_header + 33, 0)},
+        {"residue of b above the prime",
+         patchBytes(saved_rot_key, b_header + 41, ~U64ZERO)},
+        {"count of a", patchBytes(saved_rot_key, a_count, 1)},
+        {"number of primes of a", patchBytes(saved_rot_key, a_header + 16, 1)},
+    };
+    for (const auto &[what, bytes] : corrupted) {
+        std::stringstream stream(bytes);
+        SeededEvaluationKey target(context);
+        check(throwsRuntimeException([&] { target.load(stream); }),
+              std::string{"rejects "} + what);
+        KeyPack target_keypack(context);
+        check(throwsRuntimeException([&] { target.loadInto(target_keypack); }),
+              std::string{"stays empty on "} + what);
+    }
+
+    return finish("SeededEvaluationKeyTest");
+}
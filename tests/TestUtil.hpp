@@ -0,0 +1,86 @@
+////////////////////////////////////////////////////////////////////////////////
+//                                                                            //
+// Copyright (C) 2021-2023 Crypto Lab Inc.                                    //
+//                                                                            //
+// - This file is part of HEaaN homomorphic encryption library.               //
+// - HEaaN cannot be copied and/or distributed without the express permission //
+//  of Crypto Lab Inc.                                                        //
+//                                                                            //
+////////////////////////////////////////////////////////////////////////////////
+
+// Helpers shared by the tests: failure counting, message comparison and
+// corruption of serialized data.
+
+#pragma once
+
+#include <algorithm>
+#include <cmath>
+#include <cstdlib>
+#include <cstring>
+#include <iostream>
+#include <string>
+#include <utility>
+
+#include "HEaaN/HEaaN.hpp"
+
+namespace HEaaN::test {
+
+inline int failures = 0;
+
+inline void check(bool condition, const std::string &what) {
+    if (!condition) {
+        std::cerr << "FAILED: " << what << std::endl;
+        ++failures;
+    }
+}
+
+// Exit code of a test named name, printing that it passed if it did.
+inline int finish(const std::string &name) {
+    if (failures != 0)
+        return EXIT_FAILURE;
+    std::cout << name << " passed" << std::endl;
+    return EXIT_SUCCESS;
+}
+
+inline Real maxError(const Message &msg1, const Message &msg2) {
+    Real error = 0;
+    for (u64 i = 0; i < msg1.getSize(); ++i)
+        error = std::max(error, std::abs(msg1[i] - msg2[i]));
+    return error;
+}
+
+// Serialized data with the 64-bit word at byte offset replaced by word.
+inline std::string patchBytes(std::string bytes, u64 offset, u64 word) {
+    std::memcpy(&bytes[offset], &word, sizeof(u64));
+    return bytes;
+}
+
+// Serialized data with the index-th 64-bit word replaced by word.
+inline std::string patchWord(std::string bytes, u64 index, u64 word) {
+    return patchBytes(std::move(bytes), index * sizeof(u64), word);
+}
+
+// The 64-bit word at byte offset of serialized data.
+inline u64 readWordAt(const std::string &bytes, u64 offset) {
+    u64 word;
+    std::memcpy(&word, &bytes[offset], sizeof(u64));
+    return word;
+}
+
+// Serialized data corrupted in the way what describes.
+struct CorruptedInput {
+    const char *what;
+    std::string bytes;
+};
+
+// Whether func throws a RuntimeException.
+template <typename Func> bool throwsRuntimeException(Func &&func) {
+    try {
+        func();
+    } catch (const RuntimeException &) {
+        return true;
+    }
+    return false;
+}
+
+} // namespace HEaaN::test